@@ -6,6 +6,13 @@ Asynchronous http/ws session
 
 \author  jiangyong
 \update
+  2026-10-17 streaming request body is opt-in, session_http(ss, bodystream) default reject large or chunked body
+  2026-10-17 add setHttpDownFd, download file opened and checked by the server
+  2026-10-17 add streaming request body with chunked decoding, chunked response body from httpbodysource
+  2026-10-17 add EC_AIO_WS_RBUF_RING, websocket session receive buffer use parsebuffer ring mode
+  2026-10-17 DoUpgradeWebSocket temporary strings use the session arena
+  2026-10-17 session_http download big file by sendfile() from an opened fd, no read and copy
+  2026-10-17 add onrecvview, http request as a view in _rbuf, session_http recv directly into _rbuf
   2023-12-13 增加会话连接消息处理均衡
   2023-8-10 update DoUpgradeWebSocket() logout infomation
   2023-5-21 update for http download big file
@@ -23,6 +30,25 @@ You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2
 #include "ec_http.h"
 #include "ec_wstips.h"
 #include "ec_diskio.h"
+#ifndef _WIN32
+#include <sys/sendfile.h>
+#endif
+
+#ifndef EC_AIO_SENDFILE_ONCE
+#define EC_AIO_SENDFILE_ONCE (1024 * 1024) // max bytes of one sendfile() call
+#endif
+
+#ifndef EC_AIO_HTTP_CHUNKSIZE
+#ifdef _MEM_TINY
+#define EC_AIO_HTTP_CHUNKSIZE (1024 * 16) // max bytes of one chunk read from httpbodysource
+#else
+#define EC_AIO_HTTP_CHUNKSIZE (1024 * 64)
+#endif
+#endif
+
+#ifndef EC_AIO_WS_RBUF_RING // >0: websocket session _rbuf use ring mode with this min capacity, see parsebuffer::setring
+#define EC_AIO_WS_RBUF_RING 0
+#endif
 
 namespace ec {
 	namespace aio {
@@ -30,7 +56,12 @@ namespace ec {
 		public:
 			basews() : _nws(PROTOCOL_HTTP)
 				, _wscompress(0)
-				, _comp(0), _opcode(WS_OP_TXT) {
+				, _comp(0), _opcode(WS_OP_TXT)
+				, _bodystreamon(false), _bodystream(0), _bodyleft(0), _bodysrc(nullptr) {
+			}
+			~basews() {
+				if (_bodysrc)
+					delete _bodysrc;
 			}
 
 		protected:
@@ -39,6 +70,11 @@ namespace ec {
 			bytes _wsmsg; // ws frame
 			int _comp;// compress flag
 			int _opcode;  // operate code
+			bool _bodystreamon; // enable streaming request body, false: chunked body or body larger than MAXSIZE_RCVHTTPBODY failed
+			int _bodystream; // receiving request body in stream mode, 0: no; 1: "Content-Length"; 2: chunked
+			long long _bodyleft; // bytes left of the "Content-Length" body
+			ec::http::chunkdecoder _chunkdec;
+			httpbodysource* _bodysrc; // chunked response body
 
 			int ws_send(int nfd, const void* pdata, size_t size, ec::ilog* plog, int optcode = WS_OP_TXT) //if https, rewrite it
 			{
@@ -71,7 +107,7 @@ namespace ec {
 			bool DoUpgradeWebSocket(int nfd, const char* skey, ec::http::package* pPkg, ec::ilog* plog)
 			{
 				if (plog) {
-					ec::string hedinfo;
+					ec::astring hedinfo;
 					pPkg->headinfo(hedinfo);
 					plog->add(CLOG_DEFAULT_DBG, "ucid(%u) upgrade websocket:\n%s", nfd, hedinfo.c_str());
 				}
@@ -84,7 +120,7 @@ namespace ec {
 					const char* sreterr_400 = "http/1.1 400  Bad Request!\r\nConnection:keep-alive\r\n\r\n";
 					return ws_send(nfd, sreterr_400, strlen(sreterr_400), plog) >= 0;
 				}
-				ec::string vret;
+				ec::astring vret;
 				vret.reserve(1024 * 4);
 				const char* sc = "HTTP/1.1 101 Switching Protocols\x0d\x0a"\
 					"Upgrade: websocket\x0d\x0a"\
@@ -287,15 +323,23 @@ namespace ec {
 				return he_waitdata;
 			}
 
+			/**
+			 * @brief parse http or websocket message
+			 * @param pviewsize not nullptr: output http request as a view at the head of rbuf, caller free it by rbuf.freehead(*pviewsize)
+			*/
 			template<class _Out>
-			int DoReadData(int nfd, const char* pdata, size_t usize, _Out* pmsgout, ec::ilog* plog, ec::parsebuffer &rbuf)
+			int DoReadData(int nfd, const char* pdata, size_t usize, _Out* pmsgout, ec::ilog* plog, ec::parsebuffer &rbuf, size_t* pviewsize = nullptr)
 			{
 				size_t sizedo = 0;
 				rbuf.append(pdata, usize);
 				pmsgout->clear();
+				if (pviewsize)
+					*pviewsize = 0;
 				if (_nws == PROTOCOL_HTTP) {
+					if (_bodystream)
+						return DoReadBody(pmsgout, rbuf, pviewsize);
 					ec::http::package prs;
-					int nr = prs.parse((const char*)rbuf.data_(), rbuf.size_());
+					int nr = prs.parse((const char*)rbuf.data_(), rbuf.size_(), _bodystreamon);
 					if (nr > 0) {
 						if (prs.ismethod("GET")) {
 							char skey[128];
@@ -305,6 +349,15 @@ namespace ec {
 								return bupws ? he_waitdata : he_failed;
 							}
 						}
+						if (prs.isbodystream()) { // the head only, body fragments follow
+							_bodystream = prs._chunked ? 2 : 1;
+							_bodyleft = prs._chunked ? 0 : prs._contentlength;
+							_chunkdec.reset();
+						}
+						if (pviewsize) {
+							*pviewsize = (size_t)nr;
+							return he_ok;
+						}
 						pmsgout->append((uint8_t*)rbuf.data_(), nr);
 						rbuf.freehead(nr);
 						return he_ok;
@@ -327,6 +380,84 @@ namespace ec {
 				}
 				return nr;
 			}
+
+			/**
+			 * @brief parse the next fragment of the streaming request body
+			 * @return he_body or he_bodyend: the fragment is a view at the head of rbuf if pviewsize not nullptr, or in pmsgout;
+			 *  he_waitdata; he_failed
+			*/
+			template<class _Out>
+			int DoReadBody(_Out* pmsgout, ec::parsebuffer &rbuf, size_t* pviewsize)
+			{
+				size_t zfrm = 0;
+				int nst = he_body;
+				if (1 == _bodystream) {
+					zfrm = rbuf.size_();
+					if ((long long)zfrm >= _bodyleft) {
+						zfrm = (size_t)_bodyleft;
+						_bodystream = 0;
+						nst = he_bodyend;
+					}
+					else if (!zfrm)
+						return he_waitdata;
+					_bodyleft -= (long long)zfrm;
+				}
+				else {
+					size_t sizedo = 0;
+					int nr = _chunkdec.parse((const char*)rbuf.data_(), rbuf.size_(), sizedo);
+					if (sizedo)
+						rbuf.freehead(sizedo);
+					if (nr < 0) {
+						rbuf.free();
+						return he_failed;
+					}
+					if (2 == nr) {
+						_bodystream = 0;
+						nst = he_bodyend;
+					}
+					else if (1 == nr && rbuf.size_()) {
+						zfrm = rbuf.size_();
+						if (zfrm > _chunkdec.datasize())
+							zfrm = (size_t)_chunkdec.datasize();
+						_chunkdec.consume(zfrm);
+					}
+					else
+						return he_waitdata;
+				}
+				if (zfrm && pviewsize) {
+					*pviewsize = zfrm;
+					return nst;
+				}
+				if (zfrm) {
+					pmsgout->append((uint8_t*)rbuf.data_(), zfrm);
+					rbuf.freehead(zfrm);
+				}
+				return nst;
+			}
+
+			/**
+			 * @brief read a chunk from _bodysrc and send, send the last chunk at the end of body
+			 * @return return false will disconnected
+			*/
+			bool sendbodysource()
+			{
+				ec::bytes sbuf;
+				sbuf.reserve(EC_AIO_HTTP_CHUNKSIZE + 16);
+				sbuf.append((const uint8_t*)"00000000\r\n", 10); // chunk-size, fill after read
+				int nr = _bodysrc->read(&sbuf, EC_AIO_HTTP_CHUNKSIZE);
+				if (nr < 0)
+					return false;
+				if (!nr || sbuf.size() <= 10u) {
+					delete _bodysrc;
+					_bodysrc = nullptr;
+					return session_send("0\r\n\r\n", 5, nullptr) >= 0;
+				}
+				char sz[16];
+				snprintf(sz, sizeof(sz), "%08zx", sbuf.size() - 10u);
+				memcpy(sbuf.data(), sz, 8);
+				sbuf.append((const uint8_t*)"\r\n", 2);
+				return session_send(sbuf.data(), sbuf.size(), nullptr) >= 0;
+			}
 		};
 
 		class session_http : public session, public basews
@@ -335,14 +466,23 @@ namespace ec {
 			long long _downpos; //下载文件位置
 			long long _sizefile;//文件总长度
 			ec::string _downfilename;
+			int _downfd; //opened download file, -1: not open
 		public:
-			session_http(session&& ss) : session(std::move(ss)), _downpos(0), _sizefile(0)
+			session_http(session&& ss, bool bodystream = false) : session(std::move(ss)), _downpos(0), _sizefile(0), _downfd(-1)
 			{
 				_protocol = EC_AIO_PROC_HTTP;
+				_bodystreamon = bodystream;
+			}
+			virtual ~session_http()
+			{
+				closedownfd();
 			}
 		protected:
 			virtual void onupdatews() {
 				_protocol = EC_AIO_PROC_WS;
+#if EC_AIO_WS_RBUF_RING
+				_rbuf.setring(EC_AIO_WS_RBUF_RING);
+#endif
 			}
 
 			virtual int session_send(const void* pdata, size_t size, ec::ilog* plog) {
@@ -350,11 +490,30 @@ namespace ec {
 			}
 		public:
 			virtual int onrecvbytes(const void* pdata, size_t size, ec::ilog* plog, ec::bytes* pmsgout)
+			{
+				return parsehttp(pdata, size, plog, pmsgout, nullptr);
+			};
+
+			virtual int onrecvview(const void* pdata, size_t size, ec::ilog* plog, ec::bytes* pmsgout, size_t* pviewsize)
+			{
+				return parsehttp(pdata, size, plog, pmsgout, pviewsize);
+			}
+
+			virtual bool rbufrecv()
+			{
+				return true;
+			}
+		protected:
+			int parsehttp(const void* pdata, size_t size, ec::ilog* plog, ec::bytes* pmsgout, size_t* pviewsize)
 			{
 				_lastappmsg = 0;
-				int nr = DoReadData(_fd, (const char*)pdata, size, pmsgout, plog, _rbuf);
+				int nr = DoReadData(_fd, (const char*)pdata, size, pmsgout, plog, _rbuf, pviewsize);
 				if (he_failed == nr)
 					return EC_AIO_MSG_ERR;
+				else if (he_body == nr || he_bodyend == nr) {
+					_lastappmsg = 1;
+					return he_body == nr ? EC_AIO_MSG_HTTPBODY : EC_AIO_MSG_HTTPBODYEND;
+				}
 				else if (he_ok == nr) {
 					if (PROTOCOL_HTTP == _nws) {
 						_lastappmsg = 1;
@@ -367,8 +526,8 @@ namespace ec {
 					return EC_AIO_MSG_NUL;
 				}
 				return EC_AIO_MSG_NUL; //wait
-			};
-
+			}
+		public:
 			// return -1:error; or (int)size
 			virtual int sendasyn(const void* pdata, size_t size, ec::ilog* plog)
 			{
@@ -376,14 +535,16 @@ namespace ec {
 			}
 			virtual bool onSendCompleted() //return false will disconnected
 			{
+				if (_bodysrc && _protocol == EC_AIO_PROC_HTTP)
+					return sendbodysource();
 				if (_protocol != EC_AIO_PROC_HTTP || !_sizefile || _downfilename.empty())
 					return true;
 				if (_downpos >= _sizefile) {
-					_downpos = 0;
-					_sizefile = 0;
-					_downfilename.clear();
+					enddown();
 					return true;
 				}
+				if (_downfd >= 0)
+					return true; // zero-copy, sent by sendfilejob()
 				ec::string sbuf;
 #ifdef _MEM_TINY
 				long long lread = 1024 * 30;
@@ -395,33 +556,97 @@ namespace ec {
 				if (!io::lckread(_downfilename.c_str(), &sbuf, _downpos, lread, _sizefile))
 					return false;
 				if (sbuf.empty()) {
-					_downpos = 0;
-					_sizefile = 0;
-					_downfilename.clear();
+					enddown();
 					return true;
 				}
 				_downpos += (long long)sbuf.size();
 				if (_downpos >= _sizefile) {
-					_downpos = 0;
-					_sizefile = 0;
-					_downfilename.clear();
+					enddown();
 				}
 				return session::sendasyn(sbuf.data(), sbuf.size(), nullptr) >= 0;
 			}
 
 			virtual void setHttpDownFile(const char* sfile, long long pos, long long filelen)
 			{
+				closedownfd();
 				if (sfile && *sfile)
 					_downfilename = sfile;
 				else
 					_downfilename.clear();
 				_downpos = pos;
 				_sizefile = filelen;
+#ifndef _WIN32
+				if (_downfilename.size() && pos < filelen)
+					_downfd = ::open(_downfilename.c_str(), O_RDONLY | O_CLOEXEC); // if failed, onSendCompleted() read by lckread
+#endif
+			}
+#ifndef _WIN32
+			virtual void setHttpDownFd(int fdfile, const char* sfile, long long pos, long long filelen)
+			{
+				setHttpDownFile(nullptr, 0, 0);
+				_downfilename = sfile;
+				_downpos = pos;
+				_sizefile = filelen;
+				_downfd = fdfile;
+			}
+#endif
+
+			virtual int sendfilejob(int sysfd)
+			{
+#ifdef _WIN32
+				return 0;
+#else
+				if (_downfd < 0 || _protocol != EC_AIO_PROC_HTTP || !_sizefile)
+					return 0;
+				if (_downpos >= _sizefile) {
+					enddown();
+					return 0;
+				}
+				off_t off = (off_t)_downpos;
+				size_t zsend = EC_AIO_SENDFILE_ONCE;
+				if (_downpos + (long long)zsend > _sizefile)
+					zsend = (size_t)(_sizefile - _downpos);
+				ssize_t ns = ::sendfile(sysfd, _downfd, &off, zsend);
+				if (ns < 0)
+					return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+				if (!ns) // file truncated
+					return -1;
+				_downpos += ns;
+				if (_downpos >= _sizefile)
+					enddown();
+				return (int)ns;
+#endif
+			}
+
+			virtual bool setHttpBodySource(httpbodysource* psrc)
+			{
+				enddown();
+				if (_bodysrc)
+					delete _bodysrc;
+				_bodysrc = psrc;
+				return true;
 			}
 
 			virtual bool hasSendJob() {
-				return _sizefile && _downfilename.size();
+				return (_sizefile && _downfilename.size()) || _bodysrc;
 			};
+		protected:
+			void closedownfd()
+			{
+#ifndef _WIN32
+				if (_downfd >= 0) {
+					::close(_downfd);
+					_downfd = -1;
+				}
+#endif
+			}
+			void enddown()
+			{
+				closedownfd();
+				_downpos = 0;
+				_sizefile = 0;
+				_downfilename.clear();
+			}
 		};
 	}//namespace aio
 }//namespace ec
\ No newline at end of file
@@ -6,6 +6,12 @@ Asynchronous https/wss session
 
 \author  jiangyong
 \update
+  2026-10-17 streaming request body is opt-in, session_https(ss, bodystream)
+  2026-10-17 add setHttpDownFd, download file opened and checked by the server
+  2026-10-17 add streaming request body and chunked response body from httpbodysource
+  2026-10-17 websocket session receive buffer use parsebuffer ring mode if EC_AIO_WS_RBUF_RING > 0
+  2026-10-17 download big file by pread from the opened fd, no reopen and lock every chunk
+  2026-10-17 add onrecvview, https request as a view in _rbuf
   2023-12-13 增加会话连接消息处理均衡
   2023-5-21 update for http download big file
 
@@ -26,22 +32,43 @@ namespace ec {
 			long long _downpos; //下载文件位置
 			long long _sizefile;//文件总长度
 			ec::string _downfilename;
+			int _downfd; //opened download file, -1: not open
 		public:
-			session_https(session_tls&& ss) : session_tls(std::move(ss)), _downpos(0), _sizefile(0)
+			session_https(session_tls&& ss, bool bodystream = false) : session_tls(std::move(ss)), _downpos(0), _sizefile(0), _downfd(-1)
 			{
 				_protocol = EC_AIO_PROC_HTTPS;
+				_bodystreamon = bodystream;
+			}
+			virtual ~session_https()
+			{
+				closedownfd();
 			}
 		protected:
 			virtual void onupdatews() {
 				_protocol = EC_AIO_PROC_WSS;
+#if EC_AIO_WS_RBUF_RING
+				_rbuf.setring(EC_AIO_WS_RBUF_RING);
+#endif
 			}
 			virtual int session_send(const void* pdata, size_t size, ec::ilog* plog) {
 				return session_tls::sendasyn(pdata, size, plog);
 			}
 		public:
 			virtual int onrecvbytes(const void* pdata, size_t size, ec::ilog* plog, ec::bytes* pmsgout)
+			{
+				return parsehttps(pdata, size, plog, pmsgout, nullptr);
+			};
+
+			virtual int onrecvview(const void* pdata, size_t size, ec::ilog* plog, ec::bytes* pmsgout, size_t* pviewsize)
+			{
+				return parsehttps(pdata, size, plog, pmsgout, pviewsize);
+			}
+		protected:
+			int parsehttps(const void* pdata, size_t size, ec::ilog* plog, ec::bytes* pmsgout, size_t* pviewsize)
 			{
 				int nr = 0;
+				if (pviewsize)
+					*pviewsize = 0;
 				pmsgout->clear();
 				if (pdata && size) {
 					nr = session_tls::onrecvbytes(pdata, size, plog, pmsgout);
@@ -49,9 +76,13 @@ namespace ec {
 						return nr;
 				}
 				_lastappmsg = 0;
-				nr = DoReadData(_fd, (const char*)pmsgout->data(), pmsgout->size(), pmsgout, plog, _rbuf);
+				nr = DoReadData(_fd, (const char*)pmsgout->data(), pmsgout->size(), pmsgout, plog, _rbuf, pviewsize);
 				if (he_failed == nr)
 					return EC_AIO_MSG_ERR;
+				else if (he_body == nr || he_bodyend == nr) {
+					_lastappmsg = 1;
+					return he_body == nr ? EC_AIO_MSG_HTTPBODY : EC_AIO_MSG_HTTPBODYEND;
+				}
 				else if (he_ok == nr) {
 					if (PROTOCOL_HTTP == _nws) {
 						_lastappmsg = 1;
@@ -64,8 +95,8 @@ namespace ec {
 					return EC_AIO_MSG_NUL;
 				}
 				return EC_AIO_MSG_NUL; //wait
-			};
-
+			}
+		public:
 			// return -1:error; or (int)size
 			virtual int sendasyn(const void* pdata, size_t size, ec::ilog* plog)
 			{
@@ -73,12 +104,12 @@ namespace ec {
 			}
 			virtual bool onSendCompleted() //return false will disconnected
 			{
+				if (_bodysrc && _protocol == EC_AIO_PROC_HTTPS)
+					return sendbodysource();
 				if (_protocol != EC_AIO_PROC_HTTPS || !_sizefile || _downfilename.empty())
 					return true;
 				if (_downpos >= _sizefile) {
-					_downpos = 0;
-					_sizefile = 0;
-					_downfilename.clear();
+					enddown();
 					return true;
 				}
 				ec::string sbuf;
@@ -89,36 +120,80 @@ namespace ec {
 #endif
 				if (_downpos + lread > _sizefile)
 					lread = _sizefile - _downpos;
+#ifndef _WIN32
+				if (_downfd >= 0) {
+					if (io::readfd(_downfd, &sbuf, _downpos, (size_t)lread) < 0)
+						return false;
+				}
+				else
+#endif
 				if (!io::lckread(_downfilename.c_str(), &sbuf, _downpos, lread, _sizefile))
 					return false;
 				if (sbuf.empty()) {
-					_downpos = 0;
-					_sizefile = 0;
-					_downfilename.clear();
+					enddown();
 					return true;
 				}
 				_downpos += (long long)sbuf.size();
 				if (_downpos >= _sizefile) {
-					_downpos = 0;
-					_sizefile = 0;
-					_downfilename.clear();
+					enddown();
 				}
 				return session_tls::sendasyn(sbuf.data(), sbuf.size(), nullptr) >= 0;
 			}
 
 			virtual void setHttpDownFile(const char* sfile, long long pos, long long filelen)
 			{
+				closedownfd();
 				if (sfile && *sfile)
 					_downfilename = sfile;
 				else
 					_downfilename.clear();
 				_downpos = pos;
 				_sizefile = filelen;
+#ifndef _WIN32
+				if (_downfilename.size() && pos < filelen)
+					_downfd = ::open(_downfilename.c_str(), O_RDONLY | O_CLOEXEC); // if failed, read by lckread
+#endif
+			}
+#ifndef _WIN32
+			virtual void setHttpDownFd(int fdfile, const char* sfile, long long pos, long long filelen)
+			{
+				setHttpDownFile(nullptr, 0, 0);
+				_downfilename = sfile;
+				_downpos = pos;
+				_sizefile = filelen;
+				_downfd = fdfile;
+			}
+#endif
+
+			virtual bool setHttpBodySource(httpbodysource* psrc)
+			{
+				enddown();
+				if (_bodysrc)
+					delete _bodysrc;
+				_bodysrc = psrc;
+				return true;
 			}
 
 			virtual bool hasSendJob() {
-				return _sizefile && _downfilename.size();
+				return (_sizefile && _downfilename.size()) || _bodysrc;
 			};
+		protected:
+			void closedownfd()
+			{
+#ifndef _WIN32
+				if (_downfd >= 0) {
+					::close(_downfd);
+					_downfd = -1;
+				}
+#endif
+			}
+			void enddown()
+			{
+				closedownfd();
+				_downpos = 0;
+				_sizefile = 0;
+				_downfilename.clear();
+			}
 		};
 	}// namespace aio
 }// namespace ec
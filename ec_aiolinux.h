@@ -5,6 +5,12 @@
 
 \author jiangyong
 
+\update 2026-10-17 add sendiov_, gathered send of io_buffer blocks
+\update 2026-10-17 add attach_tcp_, getfdinfo and operation state of fd for io_uring server
+\update 2026-10-17 accept4 and create fd with CLOEXEC flag, add recvmmsg_ and sendmmsg_
+\update 2026-10-17 dense slot table with generation replace hashmap, O(1) kfd lookup, fd file written in batches, getmap() return a view of used slots
+\update 2026-10-17 send_ use MSG_DONTWAIT, never block the epoll thread
+\update 2026-10-17 add fd space for multi-reactor, SO_REUSEPORT listen and eventfd wakeup
 \update 2023-6-6  增加可持续fd
 \update 2023-2-1  增加TCP ipv6支持
 \update 2022-11-9 适配ec_aiosrv.h
@@ -26,9 +32,9 @@ You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2
 #include <netinet/in.h>
 #include <fcntl.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 #include <string>
-#include "ec_map.h"
 #include "ec_netio.h"
 #include "ec_jsonx.h"
 #include "ec_vector.hpp"
@@ -36,6 +42,9 @@ You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2
 #ifndef SIZE_MAX_FD
 #define SIZE_MAX_FD  16384 //最大fd连接数
 #endif
+#ifndef EC_AIO_FDFILE_GENS
+#define EC_AIO_FDFILE_GENS 16 // generations reserved per fd file writing
+#endif
 
 class netio_linux
 {
@@ -45,69 +54,129 @@ public:
 		fd_tcpout,
 		fd_listen,
 		fd_epoll,
-		fd_udp
+		fd_udp,
+		fd_event
 	};
 
 	struct t_fd
 	{
-		int  kfd;
+		int  kfd; // -1: free slot
 		int  fdtype;
 		int  sysfd; //>=0;  <0 error
 		uint32_t pollevents;
-	};
-
-	struct keq_fd
-	{
-		bool operator()(int key, const t_fd& val)
-		{
-			return key == val.kfd;
-		}
+		int  gen; // generation of slot, increase when the slot released
+		int  nextfree; // next free slot, -1: end
+		uint32_t uflags; // io_uring server, operations state
+		int  usends; // io_uring server, send operations in flight
 	};
 
 private:
-	int _nextfd;
+	int _fdspaceid; // fd space id, kfd % _fdspaces == _fdspaceid
+	int _fdspaces; // number of fd spaces, one space per reactor in multi-reactor mode
 	int _sizercvbuf, _sizesndbuf; // kbytes
-	ec::hashmap<int, t_fd, keq_fd> _mapfd;
+	int _fdfileval; // kfd value read from fd file, new kfd will be greater than it
+	int _genstart; // generation of new slot
+	int _genmax; // max generation, kfd <= INT32_MAX
+	int _genreserved; // generations <= _genreserved have been written to fd file
+	int _freehead, _freetail; // FIFO list of free slots, reuse the earliest released slot
+	size_t _numfds;
+	ec::vector<t_fd> _slots; // kfd = (gen * SIZE_MAX_FD + slot) * _fdspaces + _fdspaceid
 	std::string _sfdfile;
 
-	int nextfd()
-	{
-		if (_mapfd.size() >= SIZE_MAX_FD)
-			return -1;
-		do {
-			++_nextfd;
-			if (_nextfd == INT32_MAX)
-				_nextfd = 1;
-		} while (_mapfd.has(_nextfd));
-		if (!_sfdfile.empty()) {
-			FILE* pf = ec::io::fopen(_sfdfile.c_str(), "wt");
-			if (pf) {
-				char sid[40] = { 0 };
-				snprintf(sid, sizeof(sid), "%d", _nextfd);
-				fwrite(sid, 1, strlen(sid), pf);
-				fclose(pf);
-			}
-		}
-		return _nextfd;
+	inline t_fd* getfd_(int kfd)
+	{
+		if (kfd < 0)
+			return nullptr;
+		size_t slot = static_cast<size_t>(kfd / _fdspaces) % SIZE_MAX_FD;
+		if (slot >= _slots.size() || _slots[slot].kfd != kfd)
+			return nullptr;
+		return &_slots[slot];
 	}
 
-	void setfd(int kfd, fdtype type, int sysfd)
+	int nextfd() // return the kfd of next slot, the slot is taken by setfd()
 	{
-		t_fd t;
-		int flags = fcntl(sysfd, F_GETFD);
-		flags |= FD_CLOEXEC;
-		fcntl(sysfd, F_SETFD, flags);
+		int slot, gen;
+		if (_slots.size() < SIZE_MAX_FD) { // use all slots before reuse, kfd will not be repeated soon
+			slot = static_cast<int>(_slots.size());
+			gen = _genstart;
+		}
+		else if (_freehead >= 0) {
+			slot = _freehead;
+			gen = _slots[slot].gen;
+		}
+		else
+			return -1;
+		if (gen > _genreserved)
+			reservegen(gen);
+		return (gen * SIZE_MAX_FD + slot) * _fdspaces + _fdspaceid;
+	}
 
+	void setfd(int kfd, fdtype type, int sysfd) // sysfd created with CLOEXEC flag
+	{
+		int slot = (kfd / _fdspaces) % SIZE_MAX_FD;
+		if (slot == static_cast<int>(_slots.size())) {
+			_slots.push_back(t_fd());
+			_slots[slot].gen = _genstart;
+		}
+		else {
+			_freehead = _slots[slot].nextfree;
+			if (_freehead < 0)
+				_freetail = -1;
+		}
+		t_fd& t = _slots[slot];
 		t.kfd = kfd;
 		t.fdtype = type;
 		t.sysfd = sysfd;
 		t.pollevents = 0;
-		_mapfd.set(kfd, t);
+		t.nextfree = -1;
+		t.uflags = 0;
+		t.usends = 0;
+		++_numfds;
+	}
+
+	void freefd(t_fd* p) // release slot to the tail of free list
+	{
+		int slot = (p->kfd / _fdspaces) % SIZE_MAX_FD;
+		p->kfd = -1;
+		p->sysfd = -1;
+		p->gen = p->gen >= _genmax ? 1 : p->gen + 1;
+		p->nextfree = -1;
+		if (_freetail >= 0)
+			_slots[_freetail].nextfree = slot;
+		else
+			_freehead = slot;
+		_freetail = slot;
+		--_numfds;
 	}
 
 	bool socketfull()
 	{
-		return _mapfd.size() >= SIZE_MAX_FD;
+		return _numfds >= SIZE_MAX_FD;
+	}
+
+	void reservegen(int gen) // write fd file once per EC_AIO_FDFILE_GENS generations, not once per kfd
+	{
+		_genreserved = gen + EC_AIO_FDFILE_GENS - 1;
+		if (_genreserved > _genmax)
+			_genreserved = _genmax;
+		if (_sfdfile.empty())
+			return;
+		FILE* pf = ec::io::fopen(_sfdfile.c_str(), "wt");
+		if (pf) {
+			char sid[40] = { 0 };
+			snprintf(sid, sizeof(sid), "%lld", ((long long)_genreserved + 1) * SIZE_MAX_FD * _fdspaces - 1);
+			fwrite(sid, 1, strlen(sid), pf);
+			fclose(pf);
+		}
+	}
+
+	void resetgen() // new kfd > _fdfileval
+	{
+		_genmax = INT32_MAX / _fdspaces / SIZE_MAX_FD - 1;
+		_genstart = _fdfileval / _fdspaces / SIZE_MAX_FD + 1;
+		if (_genstart > _genmax)
+			_genstart = 1;
+		_genreserved = _genstart - 1;
 	}
 
 public:
@@ -124,26 +193,113 @@ public:
 		if (pf) {
 			char sid[40] = { 0 };
 			if(fread(sid, 1, sizeof(sid) - 1u, pf) > 0)
-				_nextfd = atoi(sid);
+				_fdfileval = atoi(sid);
 			fclose(pf);
-			if (_nextfd < 0)
-				_nextfd = 0;
+			if (_fdfileval < 0)
+				_fdfileval = 0;
 		}
+		resetgen();
+	}
+
+	/**
+	 * @brief set fd space for multi-reactor, call before create any fd
+	 * @param nid fd space id, 0 <= nid < nspaces
+	 * @param nspaces number of fd spaces(reactors)
+	 * @remark all kfd created satisfy kfd % nspaces == nid, so the owner reactor can be found by kfd.
+	*/
+	void setfdspace(int nid, int nspaces)
+	{
+		if (nspaces < 1 || nid < 0 || nid >= nspaces)
+			return;
+		_fdspaceid = nid;
+		_fdspaces = nspaces;
+		resetgen();
 	}
 	inline int geterrno() {
 		return errno;
 	}
-	ec::hashmap<int, t_fd, keq_fd>& getmap() {
-		return _mapfd;
+
+	/**
+	 * @brief read only view of the used slots, iterate and find like the fd hashmap before.
+	 * @remark for (auto& i : getmap()) skip free slots; do not create or close fd while iterating.
+	*/
+	class fdmap
+	{
+	public:
+		class iterator
+		{
+		public:
+			iterator(t_fd* p, t_fd* pend) : _p(p), _pend(pend) {
+				skip();
+			}
+			t_fd& operator*() const {
+				return *_p;
+			}
+			t_fd* operator->() const {
+				return _p;
+			}
+			iterator& operator++() {
+				++_p;
+				skip();
+				return *this;
+			}
+			bool operator==(const iterator& v) const {
+				return _p == v._p;
+			}
+			bool operator!=(const iterator& v) const {
+				return _p != v._p;
+			}
+		private:
+			t_fd* _p, * _pend;
+			void skip() {
+				while (_p < _pend && _p->kfd < 0)
+					++_p;
+			}
+		};
+		fdmap(netio_linux* pio) : _pio(pio) {
+		}
+		iterator begin() {
+			return iterator(_pio->_slots.data(), _pio->_slots.data() + _pio->_slots.size());
+		}
+		iterator end() {
+			return iterator(_pio->_slots.data() + _pio->_slots.size(), _pio->_slots.data() + _pio->_slots.size());
+		}
+		size_t size() {
+			return _pio->_numfds;
+		}
+		bool has(int kfd) {
+			return nullptr != _pio->getfd_(kfd);
+		}
+		t_fd* get(int kfd) {
+			return _pio->getfd_(kfd);
+		}
+		bool get(int kfd, t_fd& val) {
+			t_fd* p = _pio->getfd_(kfd);
+			if (!p)
+				return false;
+			val = *p;
+			return true;
+		}
+	private:
+		netio_linux* _pio;
+	};
+	fdmap& getmap() {
+		return _fdmap;
 	}
+private:
+	fdmap _fdmap;
 public:
-	netio_linux() :_nextfd(0), _sizercvbuf(128), _sizesndbuf(128), _mapfd(1024)
+	netio_linux() : _fdspaceid(0), _fdspaces(1), _sizercvbuf(128), _sizesndbuf(128), _fdfileval(0)
+		, _freehead(-1), _freetail(-1), _numfds(0), _fdmap(this)
 	{
+		resetgen();
 	}
 	~netio_linux() {
 		ec::vector<int> vepolls;
 		vepolls.reserve(1000);
-		for (auto& i : _mapfd) {
+		for (auto& i : _slots) {
+			if (i.kfd < 0)
+				continue;
 			if (fd_epoll == i.fdtype)
 				vepolls.push_back(i.sysfd);
 			else {
@@ -152,12 +308,12 @@ public:
 				closesocket(i.sysfd);
 			}
 		}
-		_mapfd.clear();
+		_slots.clear();
 		for (auto& i : vepolls)
 			close(i);
 	}
 	inline size_t size() {
-		return _mapfd.size();
+		return _numfds;
 	}
 	template<class STR_ = std::string>
 	bool init(const char* env, STR_& errout)//{"rcvbufsize":256, "sndbufsize":8192}
@@ -191,19 +347,40 @@ public:
 		int kfd = nextfd();
 		if (kfd < 0)
 			return -1;
-		int sysfd = epoll_create(1);
+		int sysfd = epoll_create1(EPOLL_CLOEXEC);
 		if (sysfd < 0)
 			return -1;
 		setfd(kfd, fd_epoll, sysfd);
 		return kfd;
 	}
 
+	int create_eventfd_() // create nonblock eventfd for wakeup epoll_wait, return kfd
+	{
+		int kfd = nextfd();
+		if (kfd < 0)
+			return -1;
+		int sysfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (sysfd < 0)
+			return -1;
+		setfd(kfd, fd_event, sysfd);
+		return kfd;
+	}
+
+	inline int read_eventfd_(int fd) // reset eventfd counter
+	{
+		t_fd* p = getfd_(fd);
+		if (!p || fd_event != p->fdtype)
+			return -1;
+		eventfd_t v = 0;
+		return eventfd_read(p->sysfd, &v);
+	}
+
 	inline int epoll_ctl_(int epfd, int op, int fd, struct epoll_event* event)
 	{
-		t_fd* pepoll = _mapfd.get(epfd);
+		t_fd* pepoll = getfd_(epfd);
 		if (!pepoll || pepoll->fdtype != fd_epoll)
 			return -1;
-		t_fd* pfd = _mapfd.get(fd);
+		t_fd* pfd = getfd_(fd);
 		if (!pfd)
 			return -1;
 		if (event) {
@@ -216,7 +393,7 @@ public:
 
 	inline int epoll_wait_(int epfd, struct epoll_event* events, int maxevents, int timeout)
 	{
-		t_fd* pepoll = _mapfd.get(epfd);
+		t_fd* pepoll = getfd_(epfd);
 		if (!pepoll || pepoll->fdtype != fd_epoll)
 			return -1;
 		return epoll_wait(pepoll->sysfd, events, maxevents, timeout);
@@ -224,13 +401,13 @@ public:
 
 	inline void close_(int fd) //shutdown and close one fd
 	{
-		t_fd* p = _mapfd.get(fd);
+		t_fd* p = getfd_(fd);
 		if (!p)
 			return;
 		if (fd_tcp == p->fdtype || fd_tcpout == p->fdtype)
 			shutdown(p->sysfd, SHUT_RDWR);
 		close(p->sysfd);
-		_mapfd.erase(fd);
+		freefd(p);
 	}
 
 	int connect_asyn(const struct sockaddr* addr, socklen_t addrlen) //connect nobloack, return fd
@@ -238,7 +415,7 @@ public:
 		int sysfd, kfd = nextfd();
 		if (kfd < 0)
 			return -1;
-		sysfd = socket(addr->sa_family, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP);
+		sysfd = socket(addr->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
 		if (sysfd < 0)
 			return -1;
 		if (connect(sysfd, addr, addrlen) < 0) {
@@ -253,12 +430,12 @@ public:
 		return kfd;
 	}
 
-	int bind_listen(const struct sockaddr* addr, socklen_t addrlen, int ipv6only = 0) // bind and listen return fd
+	int bind_listen(const struct sockaddr* addr, socklen_t addrlen, int ipv6only = 0, int reuseport = 0) // bind and listen return fd
 	{
 		int sysfd, kfd = nextfd();
 		if (kfd < 0)
 			return -1;
-		sysfd = socket(addr->sa_family, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP);
+		sysfd = socket(addr->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
 		if (sysfd < 0)
 			return -1;
 		int opt = 1; // IPV6_V6ONLY
@@ -273,6 +450,12 @@ public:
 			close(sysfd);
 			return -1;
 		}
+		if (reuseport && -1 == setsockopt(sysfd, SOL_SOCKET, SO_REUSEPORT, (const void*)&opt, sizeof(opt))) {
+			close(sysfd);
+			return -1;
+		}
+		ec::net::setrecvbuf(sysfd, _sizercvbuf * 1024); // accepted sockets inherit the buffer size
+		ec::net::setsendbuf(sysfd, _sizesndbuf * 1024);
 		if (bind(sysfd, addr, addrlen) < 0 || listen(sysfd, SOMAXCONN) < 0) {
 			close(sysfd);
 			return -1;
@@ -288,7 +471,7 @@ public:
 			return -1;
 
 		SOCKET sysfd = INVALID_SOCKET;
-		if ((sysfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0)) == INVALID_SOCKET)
+		if ((sysfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == INVALID_SOCKET)
 			return -1;
 
 		struct sockaddr_un Addr;
@@ -312,26 +495,43 @@ public:
 
 	inline int accept_(int fd, struct sockaddr* addr, socklen_t* addrlen) // return fd
 	{
-		t_fd* p = _mapfd.get(fd);
+		t_fd* p = getfd_(fd);
 		if (!p || fd_listen != p->fdtype)
 			return -1;
-		int sysfd = accept(p->sysfd, addr, addrlen);
+		int sysfd = accept4(p->sysfd, addr, addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
 		if (sysfd < 0)
 			return -1;
 		int kfd = nextfd();
 		if (kfd < 0) {
 			close(sysfd);
+			errno = EMFILE;
 			return -1;
 		}
-		ec::net::setrecvbuf(sysfd, _sizercvbuf * 1024);
-		ec::net::setsendbuf(sysfd, _sizesndbuf * 1024);
 		setfd(kfd, fd_tcp, sysfd);
 		return kfd;
 	}
 
+	int attach_tcp_(int sysfd) // attach a tcp socket accepted by io_uring, return kfd
+	{
+		int kfd = nextfd();
+		if (kfd < 0)
+			return -1;
+		setfd(kfd, fd_tcp, sysfd);
+		return kfd;
+	}
+
+	/**
+	 * @brief get fd info, used by io_uring server to keep operations state
+	 * @remark the pointer is invalid after create new fd
+	*/
+	inline t_fd* getfdinfo(int fd)
+	{
+		return getfd_(fd);
+	}
+
 	inline int recv_(int fd, void* buf, size_t len, int flags)
 	{
-		t_fd* p = _mapfd.get(fd);
+		t_fd* p = getfd_(fd);
 		if (!p || (fd_tcp != p->fdtype && fd_tcpout != p->fdtype))
 			return -1;
 		return recv(p->sysfd, buf, len, MSG_DONTWAIT);
@@ -339,15 +539,27 @@ public:
 
 	inline int send_(int fd, const void* buf, size_t len, int flags)
 	{
-		t_fd* p = _mapfd.get(fd);
+		t_fd* p = getfd_(fd);
 		if (!p || (fd_tcp != p->fdtype && fd_tcpout != p->fdtype))
 			return -1;
-		return send(p->sysfd, buf, len, flags);
+		return send(p->sysfd, buf, len, flags | MSG_DONTWAIT);
+	}
+
+	inline int sendiov_(int fd, const struct iovec* iovs, int iovcnt, int flags) // gathered send, return bytes sent, -1:error
+	{
+		t_fd* p = getfd_(fd);
+		if (!p || (fd_tcp != p->fdtype && fd_tcpout != p->fdtype))
+			return -1;
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = (struct iovec*)iovs;
+		msg.msg_iovlen = iovcnt;
+		return (int)sendmsg(p->sysfd, &msg, flags | MSG_DONTWAIT | MSG_NOSIGNAL);
 	}
 	
 	inline int shutdown_(int fd, int how)
 	{
-		t_fd* p = _mapfd.get(fd);
+		t_fd* p = getfd_(fd);
 		if (!p || (fd_tcp != p->fdtype && fd_tcpout != p->fdtype))
 			return -1;
 		return shutdown(p->sysfd, SHUT_RDWR);
@@ -355,14 +567,16 @@ public:
 
 	void getall(ec::vector<int>& fds)
 	{
-		fds.reserve(_mapfd.size());
-		for (auto& i : _mapfd)
-			fds.push_back(i.kfd);
+		fds.reserve(_numfds);
+		for (auto& i : _slots) {
+			if (i.kfd >= 0)
+				fds.push_back(i.kfd);
+		}
 	}
 
 	int getfdtype(int fd)
 	{
-		auto* pi = _mapfd.get(fd);
+		auto* pi = getfd_(fd);
 		if (!pi)
 			return -1;
 		return pi->fdtype;
@@ -370,7 +584,7 @@ public:
 
 	int setkeepalive(int fd, bool bfast = false)
 	{
-		t_fd* p = _mapfd.get(fd);
+		t_fd* p = getfd_(fd);
 		if (!p || (fd_tcp != p->fdtype && fd_tcpout != p->fdtype))
 			return -1;
 
@@ -392,7 +606,7 @@ public:
 
 	int tcpnodelay(int fd)
 	{
-		t_fd* p = _mapfd.get(fd);
+		t_fd* p = getfd_(fd);
 		if (!p || (fd_tcp != p->fdtype && fd_tcpout != p->fdtype))
 			return -1;
 		int bNodelay = 1;
@@ -404,7 +618,7 @@ public:
 		int kfd = nextfd();
 		if (kfd < 0)
 			return -1;
-		int sysfd = socket(addr ? addr->sa_family : AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_UDP);
+		int sysfd = socket(addr ? addr->sa_family : AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
 		if (sysfd < 0)
 			return -1;
 
@@ -432,7 +646,7 @@ public:
 
 	inline int recvfrom_(int fd, void* buf, size_t len, int flags, struct sockaddr* from, socklen_t* fromlen)
 	{
-		t_fd* p = _mapfd.get(fd);
+		t_fd* p = getfd_(fd);
 		if (!p || fd_udp != p->fdtype)
 			return -1;
 		return recvfrom(p->sysfd, buf, len, MSG_DONTWAIT, from, fromlen);
@@ -440,16 +654,32 @@ public:
 
 	inline int sendto_(int fd, const void* buf, size_t len, const struct sockaddr* dest_addr, socklen_t addrlen)
 	{
-		t_fd* p = _mapfd.get(fd);
+		t_fd* p = getfd_(fd);
 		if (!p || fd_udp != p->fdtype)
 			return -1;
 		return sendto(p->sysfd, buf, len, MSG_DONTWAIT, dest_addr, addrlen);
 	}
 
+	inline int recvmmsg_(int fd, struct mmsghdr* msgvec, unsigned int vlen) // return number of datagrams received, -1:error
+	{
+		t_fd* p = getfd_(fd);
+		if (!p || fd_udp != p->fdtype)
+			return -1;
+		return recvmmsg(p->sysfd, msgvec, vlen, MSG_DONTWAIT, nullptr);
+	}
+
+	inline int sendmmsg_(int fd, struct mmsghdr* msgvec, unsigned int vlen) // return number of datagrams sent, -1:error
+	{
+		t_fd* p = getfd_(fd);
+		if (!p || fd_udp != p->fdtype)
+			return -1;
+		return sendmmsg(p->sysfd, msgvec, vlen, MSG_DONTWAIT);
+	}
+
 	int setsendbuf(int fd, int n)
 	{
 		int nval = n;
-		t_fd* p = _mapfd.get(fd);
+		t_fd* p = getfd_(fd);
 		if (!p)
 			return -1;
 		if (-1 == setsockopt(p->sysfd, SOL_SOCKET, SO_SNDBUF, (char*)&nval, (socklen_t)sizeof(nval)))
@@ -460,7 +690,7 @@ public:
 	int setrecvbuf(int fd, int n)
 	{
 		int nval = n;
-		t_fd* p = _mapfd.get(fd);
+		t_fd* p = getfd_(fd);
 		if (!p)
 			return -1;
 		if (-1 == setsockopt(p->sysfd, SOL_SOCKET, SO_RCVBUF, (char*)&nval, (socklen_t)sizeof(nval)))
@@ -470,7 +700,7 @@ public:
 
 	int getsysfd(int fd)
 	{
-		t_fd* p = _mapfd.get(fd);
+		t_fd* p = getfd_(fd);
 		if (!p)
 			return -1;
 		return p->sysfd;
@@ -479,7 +709,7 @@ public:
 	int getbufsize(int fd, int op)
 	{
 		int nlen = 4, nval = 0;
-		t_fd* p = _mapfd.get(fd);
+		t_fd* p = getfd_(fd);
 		if (!p)
 			return -1;
 		if (getsockopt(p->sysfd, SOL_SOCKET, op, (char*)&nval, (socklen_t*)&nlen) < 0)
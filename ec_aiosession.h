@@ -6,6 +6,12 @@ Asynchronous session base class
 
 \author  jiangyong
 \update
+  2026-10-17 add setHttpDownFd, download file opened and checked by the server
+  2026-10-17 add EC_AIO_MSG_HTTPBODY/EC_AIO_MSG_HTTPBODYEND streaming request body, httpbodysource chunked response body
+  2026-10-17 add _arena, per-connection bump allocator for objects scoped to one message or the session
+  2026-10-17 add sendfilejob, zero-copy send job without _sndbuf
+  2026-10-17 add onrecvview and rbufrecv, message view in _rbuf and receive directly into _rbuf
+  2026-10-17 add _rdpending for paused receive, _epollevents cache the last epoll interest mask
   2023-12-13 增加会话连接消息处理均衡
   2023-5-21 update for http download big file
 
@@ -53,6 +59,8 @@ You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2
 #define EC_AIO_MSG_HTTP  2 // include HTTPS
 #define EC_AIO_MSG_WS    3 // include WSS
 #define EC_AIO_MSG_UDP   4
+#define EC_AIO_MSG_HTTPBODY    5 // a fragment of the streaming http request body, include HTTPS
+#define EC_AIO_MSG_HTTPBODYEND 6 // the last fragment of the streaming http request body, may be empty
 
 //protocol type
 #define EC_AIO_PROC_TCP  0
@@ -157,6 +165,24 @@ namespace ec {
 			}
 		};
 
+		/*!
+		\brief body of http response with unknown length, read by the session when _sndbuf is empty and sent by chunked transfer coding
+		*/
+		class httpbodysource
+		{
+		public:
+			_USE_EC_OBJ_ALLOCATOR
+			virtual ~httpbodysource() {
+			}
+			/*!
+			\brief read the next piece of body
+			\param pout [out] append the piece
+			\param maxsize max bytes of the piece
+			\return >0: bytes appended; 0: end of body; -1: error, will disconnected
+			*/
+			virtual int read(ec::bytes* pout, size_t maxsize) = 0;
+		};
+
 		struct t_bps
 		{
 			struct t_i {
@@ -206,9 +232,11 @@ namespace ec {
 			int64_t _mstime_connected;
 			ec::parsebuffer  _rbuf;
 			ec::io_buffer<> _sndbuf;
+			ec::arena _arena; // objects scoped to one message or the session, see ec::arena::scope
 			char _peerip[48];
 			uint16_t _peerport;
-			uint32_t _epollevents;//epoll events
+			uint32_t _epollevents;//epoll events, the last interest mask set by epoll_ctl
+			int      _rdpending; //in the paused sessions of server, stopped reading by flow control, need read again
 			time_t   _time_error; //延迟断开的开始时间
 			t_bps   _bpsRcv; //接受秒流量
 			t_bps   _bpsSnd; //发送秒流量
@@ -232,6 +260,7 @@ namespace ec {
 				, _sndbuf(EC_AIO_SNDBUF_MAXSIZE, pblkallocator)
 				, _peerport(0)
 				, _epollevents(0)
+				, _rdpending(0)
 				, _time_error(0)
 				, _pextdata(nullptr)
 			{
@@ -239,7 +268,7 @@ namespace ec {
 			}
 
 			session(session&& v) noexcept
-				: _rbuf(std::move(v._rbuf)), _sndbuf(std::move(v._sndbuf))
+				: _rbuf(std::move(v._rbuf)), _sndbuf(std::move(v._sndbuf)), _arena(std::move(v._arena))
 			{
 				_keyid = v._keyid;
 				_fd = v._fd;
@@ -257,6 +286,7 @@ namespace ec {
 				v._status = 0;
 				_peerport = v._peerport;
 				_epollevents = v._epollevents;
+				_rdpending = v._rdpending;
 				_pextdata = v._pextdata;
 				_time_error = v._time_error;
 				v._bpsRcv = _bpsRcv;
@@ -308,6 +338,29 @@ namespace ec {
 				return pmsgout->empty() ? EC_AIO_MSG_NUL : _msgtype;
 			};
 
+			/*!
+			\brief do receive bytes, output the message as a view at the head of _rbuf if the protocol can
+			\param pdata [in] received byte stream, nullptr: parse the bytes already in _rbuf
+			\param size [in] received byte stream size(bytes)
+			\param pmsgout [out] application layer message copied from byte stream
+			\param pviewsize [out] >0: the message is _rbuf.data_() with *pviewsize bytes, free by
+				_rbuf.freehead(*pviewsize) after processed; 0: the message is in pmsgout
+			\return msgtype, the same as onrecvbytes
+			*/
+			virtual int onrecvview(const void* pdata, size_t size, ec::ilog* plog, ec::bytes* pmsgout, size_t* pviewsize)
+			{
+				*pviewsize = 0;
+				return onrecvbytes(pdata, size, plog, pmsgout);
+			}
+
+			/*!
+			\brief the server can recv directly into _rbuf, then call onrecvview(nullptr, 0, ...)
+			*/
+			virtual bool rbufrecv()
+			{
+				return false;
+			}
+
 			// return -1:error; or (int)size
 			virtual int sendasyn(const void* pdata, size_t size, ec::ilog* plog)
 			{
@@ -329,7 +382,28 @@ namespace ec {
 			}
 			virtual bool onSendCompleted() { return true; } //return false will disconnected
 			virtual void setHttpDownFile(const char* sfile, long long pos, long long filelen) {};
+#ifndef _WIN32
+			/*!
+			\brief set the download file already opened and checked by the server, the session own fdfile
+			*/
+			virtual void setHttpDownFd(int fdfile, const char* sfile, long long pos, long long filelen) {
+				if (fdfile >= 0)
+					::close(fdfile);
+			};
+#endif
+			virtual bool setHttpBodySource(httpbodysource* psrc) { // the session own psrc
+				if (psrc)
+					delete psrc;
+				return false;
+			};
 			virtual bool hasSendJob() { return false; };
+
+			/*!
+			\brief zero-copy send job, send file to the socket directly, the server call it when _sndbuf is empty.
+			\param sysfd system socket fd
+			\return >0: bytes sent; 0: no zero-copy job or the socket send buffer is full; -1: error, will disconnected
+			*/
+			virtual int sendfilejob(int sysfd) { return 0; };
 			virtual void onUdpSendCount(int64_t numfrms, int64_t numbytes) {};
 
 			virtual const char* ProtocolName(int nprotoocl) {
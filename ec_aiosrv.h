@@ -5,8 +5,20 @@
 * @author jiangyong
 * 
 * class ec::aio::netserver
+* class ec::aio::netreactors
 
 * @update
+	2026-10-17 domsgs open the session arena scope per message, no accumulation across pipelined messages of one round
+	2026-10-17 streaming http request body is opt-in by enable_bodystream(), default large or chunked body failed as before
+	2026-10-17 doRecvBuffer walk a copy of the fds, domsgs may add or erase sessions
+	2026-10-17 pipelining, process at most EC_AIO_MSGBUDGET messages of one session per round and coalesce the responses in one send
+	2026-10-17 POST and PUT also update HTTP protocol, protocol parse in stream mode for large or chunked request body
+	2026-10-17 postsendtofd use lock-free mpsc_queue, wakeup only once per drain, mutex queue only when the ring is full
+	2026-10-17 _mapsession use flatmap, no long chains with many connections
+	2026-10-17 parse and process one message in the session arena scope
+	2026-10-17 add domessageview, http request process as a view in session _rbuf, recv directly into _rbuf in linux
+	2026-10-17 add EC_AIO_URING, use io_uring server serveruring_ in linux
+	2026-10-17 add multi-reactor mode netreactors, SO_REUSEPORT sharding and thread safe postsendtofd
 	2023-12-21 增加总收发流量和总收发秒流量
 	2023-12-13 增加连接会话消息处理均衡,每个连接每次解析和处理一个消息。
 	2023-6-16 add tcp keepalive
@@ -24,12 +36,33 @@ You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2
 #pragma once
 
 #include "ec_aiosession.h"
+#include "ec_map.h"
 
 #ifdef _WIN32
 #include "ec_netiocp.h"
 #else
+#ifndef EC_AIO_URING
+#define EC_AIO_URING 0 // 1: use io_uring in linux, need Linux 6.0+; 0: use epoll
+#endif
+#if (0 != EC_AIO_URING)
+#include "ec_neturing.h"
+#else
 #include "ec_netepoll.h"
 #endif
+#include "ec_thread.h"
+#endif
+
+#ifndef EC_AIO_MSGBUDGET
+#define EC_AIO_MSGBUDGET 16 // max messages of one session processed per round, e.g. pipelined http requests. 1: one message per round
+#endif
+
+#ifndef EC_AIO_TCP_NODELAY
+#define EC_AIO_TCP_NODELAY 1 // 1: TCP_NODELAY for accepted connections, the responses of one round are coalesced in one send
+#endif
+
+#ifndef EC_AIO_POSTQUEUE_SIZE
+#define EC_AIO_POSTQUEUE_SIZE 4096 // lock-free ring size of messages posted by other threads, power of 2
+#endif
 
 #if (0 != EC_AIOSRV_TLS)
 #include "ec_aiotls.h"
@@ -46,6 +79,8 @@ namespace ec {
 	namespace aio {
 #ifdef _WIN32
 		using netserver_ = serveriocp_;
+#elif (0 != EC_AIO_URING)
+		using netserver_ = serveruring_;
 #else
 		using netserver_ = serverepoll_;
 #endif
@@ -53,7 +88,7 @@ namespace ec {
 		{
 		protected:
 			ec::blk_alloctor<> _sndbufblks; //共享发送缓冲分配区
-			ec::hashmap<int, psession, kep_session, del_session > _mapsession;//会话连接
+			ec::flatmap<int, psession, kep_session, del_session > _mapsession;//会话连接
 #if (0 != EC_AIOSRV_TLS)
 			tls::srvca _ca;  // certificate
 #endif
@@ -62,13 +97,37 @@ namespace ec {
 			uint64_t _allrecv = 0;//总接收
 			t_bps   _bpsRcv; //总接受秒流量
 			t_bps   _bpsSnd; //总发送秒流量
+			int _msgbudget = EC_AIO_MSGBUDGET; // max messages of one session processed per round, see setmsgbudget()
+			int _corkfd = -1; // processing messages of this fd, sendtofd() only append to _sndbuf, send by postsend() after
+			ec::vector<int> _recvbuffds; // fds walked by doRecvBuffer(), domsgs() may add or erase sessions of _mapsession
+#ifndef _WIN32
+			struct t_postmsg { // message posted by other threads
+				int _fd;
+				ec::bytes _data;
+				t_postmsg(int fd, const void* pdata, size_t size) : _fd(fd), _data((const uint8_t*)pdata, size) {
+				}
+			};
+			ec::mpsc_queue<t_postmsg> _postq; // messages wait send in the epoll thread
+			std::atomic<int> _postovf; // 1: _postq was full, post to _postmsgs until the epoll thread drained it, keep FIFO
+			std::mutex _postlck; // lock for _postmsgs
+			ec::queue<t_postmsg> _postmsgs; // overflow of _postq
+#endif
 		public:
 			netserver(ec::ilog* plog) : netserver_(plog)
 				, _sndbufblks(EC_AIO_SNDBUF_BLOCKSIZE - EC_ALLOCTOR_ALIGN, EC_AIO_SNDBUF_HEAPSIZE / EC_AIO_SNDBUF_BLOCKSIZE)
+#ifndef _WIN32
+				, _postq(EC_AIO_POSTQUEUE_SIZE), _postovf(0)
+#endif
 			{
+#ifndef _WIN32
+				_rbufrecv = true;
+#endif
 			}
 			virtual ~netserver() {
 				_mapsession.clear();
+#if !defined(_WIN32) && (0 != EC_AIO_URING)
+				_sndholds.clear(); // blocks from _sndbufblks, free before it
+#endif
 			}
 			inline void setLog(ec::ilog* plog)
 			{
@@ -78,6 +137,15 @@ namespace ec {
 			{
 				return _plog;
 			}
+
+			/**
+			 * @brief set max messages of one session processed per round, more for pipelined requests, less for fairness
+			 * @param n >= 1, 1: one message per round
+			*/
+			inline void setmsgbudget(int n)
+			{
+				_msgbudget = n < 1 ? 1 : n;
+			}
 #if (0 != EC_AIOSRV_TLS)
 			bool initca(const char* filecert, const char* filerootcert, const char* fileprivatekey)
 			{
@@ -210,8 +278,34 @@ namespace ec {
 					return -1;
 				if(pss->sendasyn(pdata, size, _plog) < 0)
 					return -1;
+				if (fd == _corkfd)
+					return 0; // coalesced with the responses of the following messages, sent by postsend() after domsgs()
 				return postsend(fd);
 			}
+#ifndef _WIN32
+			/**
+			 * @brief thread safe send, post message to the epoll thread and wakeup it, the message will be
+			 *  sent by sendtofd() in the epoll thread. lock-free unless the ring is full, only the first post
+			 *  after the epoll thread started draining writes the eventfd.
+			 * @param fd
+			 * @param pdata
+			 * @param size
+			 * @return 0: posted; -1: error
+			*/
+			int postsendtofd(int fd, const void* pdata, size_t size)
+			{
+				if (fd < 0 || !pdata || !size)
+					return -1;
+				if (_postovf.load(std::memory_order_acquire) || !_postq.push(fd, pdata, size)) {
+					ec::unique_lock lck(&_postlck);
+					_postmsgs.emplace(fd, pdata, size);
+					_postovf.store(1, std::memory_order_release);
+				}
+				if (_postq.signal())
+					wakeup();
+				return 0;
+			}
+#endif
 
 			/**
 			 * @brief 异步连接, 会建立一个默认的tcp session, 连接成功后会使用onTcpConnectOut通知
@@ -259,24 +353,35 @@ namespace ec {
 			int doRecvBuffer()
 			{
 				int msgtype, n = 0;
+				size_t zview;
 				ec::bytes msg;
 				ec::vector<int> dels;
 				dels.reserve(32);
+				int nr, fd;
+				psession pss;
+				_recvbuffds.clear(); // domsgs() may tcpconnect() or closefd(), flatmap set/erase invalidate the iterators
 				for (const auto& i : _mapsession) {
-					if (i->_time_error)
+					if (!i->_time_error && !i->hasSendJob()) // keep the order of responses, wait the send job completed
+						_recvbuffds.push_back(i->_fd);
+				}
+				for (auto i = 0u; i < _recvbuffds.size(); i++) {
+					fd = _recvbuffds[i];
+					if (!_mapsession.get(fd, pss) || pss->_time_error || pss->hasSendJob()) // closed or changed by domsgs of other fd
 						continue;
-					msgtype = i->onrecvbytes(nullptr, 0, _plog, &msg);
+					ec::arena::scope arenascope(&pss->_arena); // release the temporary objects of one message
+					msgtype = pss->onrecvview(nullptr, 0, _plog, &msg, &zview);
 					if (msgtype > EC_AIO_MSG_NUL) {
-						if (domessage(i->_fd, msg, msgtype) < 0 || postsend(i->_fd) < 0) {
-							dels.push_back(i->_fd);
+						if ((nr = domsgs(fd, msg, msgtype, zview)) < 0 || postsend(fd) < 0) {
+							dels.push_back(fd);
 						}
 						else {
-							++n;
-							_plog->add(CLOG_DEFAULT_ALL, "fd(%d) %s parse one recvbuf msgtype = %d success",
-								i->_fd,	i->ProtocolName(i->_protocol), msgtype);
+							n += nr;
+							_plog->add(CLOG_DEFAULT_ALL, "fd(%d) parse %d recvbuf msgs, msgtype = %d success", fd, nr, msgtype);
 						}
 						msg.clear();
 					}
+					else if (msgtype == EC_AIO_MSG_ERR) // e.g. bad chunk of the streaming http request body
+						dels.push_back(fd);
 				}
 				for (const auto& fd : dels) {
 					_plog->add(CLOG_DEFAULT_INF, "close fd(%d) at runrecvbuf failed", fd);
@@ -311,6 +416,15 @@ namespace ec {
 
 			virtual void onprotocol(int fd, int nproco) {};
 
+			/**
+			 * @brief 是否容许流式接收http请求体, 在升级HTTP/HTTPS协议时调用
+			 * @return true: chunked或大于MAXSIZE_RCVHTTPBODY的请求体以EC_AIO_MSG_HTTPBODY/EC_AIO_MSG_HTTPBODYEND分片交给domessage;
+			 *  false(默认): 这类请求解析失败并断开
+			*/
+			virtual bool enable_bodystream() {
+				return false;
+			}
+
 			/**
 			 * @brief 处理消息,已经分包完成
 			 * @param fd 虚拟fd
@@ -320,6 +434,77 @@ namespace ec {
 			*/
 			virtual int domessage(int fd, ec::bytes& sbuf, int msgtype) = 0;
 
+			/**
+			 * @brief 处理消息视图,消息在会话接收缓冲_rbuf中,不拷贝。默认拷贝到ec::bytes后调用domessage,应用层可重载去掉拷贝。
+			 * @param fd 虚拟fd
+			 * @param pmsg 消息包,只在本次调用中有效
+			 * @param msgsize 消息包长度
+			 * @param msgtype 消息类型 EC_AIO_MSG_XXX defined in ec_aiosession.h
+			 * @return 0:ok; -1:error, will disconnect
+			*/
+			virtual int domessageview(int fd, const uint8_t* pmsg, size_t msgsize, int msgtype)
+			{
+				ec::bytes msg;
+				msg.append(pmsg, msgsize);
+				return domessage(fd, msg, msgtype);
+			}
+
+			/**
+			 * @brief 处理一个消息
+			 * @param zview >0: 消息是会话_rbuf头部的zview字节视图,处理后释放; 0:消息在msg中
+			 * @return 0:ok; -1:error
+			*/
+			int domsg(int fd, ec::bytes& msg, int msgtype, size_t zview)
+			{
+				if (!zview)
+					return domessage(fd, msg, msgtype);
+				psession pss = getSession(fd);
+				if (!pss)
+					return -1;
+				int nr = domessageview(fd, (const uint8_t*)pss->_rbuf.data_(), zview, msgtype);
+				if (nullptr != (pss = getSession(fd))) // the session may be closed or replaced in domessageview
+					pss->_rbuf.freehead(zview);
+				return nr;
+			}
+
+			/**
+			 * @brief 处理一个消息及会话_rbuf中已完整的后续消息(如pipelining的http请求),每轮最多_msgbudget个以保持会话间均衡。
+			 *  处理期间应答只添加到_sndbuf,调用者postsend()一次合并发送。会话有发送任务(如下载大文件)时暂停,保持应答顺序。
+			 *  每个消息在会话arena的一个scope中处理,处理完即释放临时对象,不在一轮中累积。
+			 * @return 处理的消息数; -1:error
+			*/
+			int domsgs(int fd, ec::bytes& msg, int msgtype, size_t zview)
+			{
+				int n = 0, nr;
+				psession pss = getSession(fd);
+				if (!pss)
+					return -1;
+				_corkfd = fd;
+				for (;;) {
+					{
+						ec::arena::scope msgscope(&pss->_arena); // release the temporary objects of this message
+						nr = domsg(fd, msg, msgtype, zview);
+					}
+					if (nr < 0) {
+						n = -1;
+						break;
+					}
+					msg.clear();
+					if (++n >= _msgbudget || nullptr == (pss = getSession(fd)) || pss->_time_error || pss->hasSendJob())
+						break;
+					msgtype = pss->onrecvview(nullptr, 0, _plog, &msg, &zview);
+					if (msgtype == EC_AIO_MSG_ERR) {
+						_plog->add(CLOG_DEFAULT_ERR, "fd(%d) read error message.", fd);
+						n = -1;
+						break;
+					}
+					if (msgtype <= EC_AIO_MSG_NUL)
+						break;
+				}
+				_corkfd = -1;
+				return n;
+			}
+
 #if (0 != EC_AIOSRV_TLS)
 			virtual ec::tls::srvca* getCA(int fdlisten) {
 				return &_ca;
@@ -386,16 +571,18 @@ namespace ec {
 #endif
 #if (0 != EC_AIOSRV_HTTP)
 				if ((ec::strineq("head", (const char*)pu, 4)
-					|| ec::strineq("get", (const char*)pu, 3))
+					|| ec::strineq("get", (const char*)pu, 3)
+					|| ec::strineq("post", (const char*)pu, 4)
+					|| ec::strineq("put", (const char*)pu, 3))
 					) { //update http
 					ec::http::package r;
-					if (r.parse((const char*)pu, size) < 0)
+					if (r.parse((const char*)pu, size, enable_bodystream()) < 0)
 						return -1;
-					if (r.parse((const char*)pu, size) < 0 || !EnableProtocol((*pi)->_fdlisten, EC_AIO_PROC_HTTP)) {
+					if (!EnableProtocol((*pi)->_fdlisten, EC_AIO_PROC_HTTP)) {
 						(*pi)->_time_error = ::time(nullptr);//设置延迟断开开始时间
 						return 0; //不应答,延迟断开
 					}
-					psession phttp = new session_http(std::move(**pi));
+					psession phttp = new session_http(std::move(**pi), enable_bodystream());
 					if (!phttp)
 						return -1;
 					_mapsession.set(phttp->_fd, phttp);
@@ -416,14 +603,16 @@ namespace ec {
 				if (size < 3u)
 					return 0;
 				if ((ec::strineq("head", (const char*)pu, 4)
-					|| ec::strineq("get", (const char*)pu, 3))
+					|| ec::strineq("get", (const char*)pu, 3)
+					|| ec::strineq("post", (const char*)pu, 4)
+					|| ec::strineq("put", (const char*)pu, 3))
 					) { //update http
 					ec::http::package r;
-					if (r.parse((const char*)pu, size) < 0 || !EnableProtocol((*pi)->_fdlisten, EC_AIO_PROC_HTTPS)) {
+					if (r.parse((const char*)pu, size, enable_bodystream()) < 0 || !EnableProtocol((*pi)->_fdlisten, EC_AIO_PROC_HTTPS)) {
 						(*pi)->_time_error = ::time(nullptr);//设置延迟断开开始时间
 						return 0; //不应答,延迟断开
 					}
-					psession phttp = new session_https(std::move(*((session_tls*)*pi)));
+					psession phttp = new session_https(std::move(*((session_tls*)*pi)), enable_bodystream());
 					if (!phttp)
 						return -1;
 					_mapsession.set(phttp->_fd, phttp);
@@ -445,6 +634,26 @@ namespace ec {
 			 * @return 0:OK; -1:error，will be close 
 			*/
 			virtual int onReceived(int kfd, const void* pdata, size_t size)
+			{
+				return doreceived(kfd, pdata, size);
+			}
+#ifndef _WIN32
+			/**
+			 * @brief 接收数据,已直接接收到会话的_rbuf中
+			 * @param kfd   keyfd
+			 * @param size  Received data size
+			 * @return 0:OK; -1:error，will be close
+			*/
+			virtual int onReceivedRbuf(int kfd, size_t size)
+			{
+				return doreceived(kfd, nullptr, size);
+			}
+#endif
+			/**
+			 * @brief 接收数据,解析并处理一个消息
+			 * @param pdata Received data, nullptr: already in the session _rbuf
+			*/
+			int doreceived(int kfd, const void* pdata, size_t size)
 			{
 				int64_t mscurtime = ec::mstime();
 				_allrecv += size;
@@ -458,15 +667,19 @@ namespace ec {
 				}
 				pss->_allrecv += size;
 				pss->_bpsRcv.add(mscurtime, (int64_t)size);
+				if (!pdata && pss->hasSendJob()) // already in _rbuf, keep the order of responses, parse in doRecvBuffer() after the send job
+					return 0;
+				ec::arena::scope arenascope(&pss->_arena); // release the temporary objects of one message
 				ec::bytes msg;
-				int msgtype = pss->onrecvbytes(pdata, size, _plog, &msg);
+				size_t zview = 0;
+				int msgtype = pss->onrecvview(pdata, size, _plog, &msg, &zview);
 				if (EC_AIO_PROC_TCP == pss->_protocol && EC_AIO_MSG_TCP == msgtype) {
 					pss->_rbuf.append(msg.data(), msg.size());
 					int nup = onupdate_proctcp(pss->_fd, &pss);
 					if (nup != 1)
 						return nup;
 					msg.clear();
-					msgtype = pss->onrecvbytes(nullptr, 0, _plog, &msg);
+					msgtype = pss->onrecvview(nullptr, 0, _plog, &msg, &zview);
 				}
 #if (0 != EC_AIOSRV_TLS)
 				else if (EC_AIO_PROC_TLS == pss->_protocol && EC_AIO_MSG_TCP == msgtype) {
@@ -475,15 +688,15 @@ namespace ec {
 					if (nup != 1)
 						return nup;
 					msg.clear();
-					msgtype = pss->onrecvbytes(nullptr, 0, _plog, &msg);
+					msgtype = pss->onrecvview(nullptr, 0, _plog, &msg, &zview);
 				}
 #endif
-				if (msgtype > EC_AIO_MSG_NUL) { //只处理一个消息,剩下得在doRecvBuffer中处理。
-					if (domessage(pss->_fd, msg, msgtype) < 0)
+				if (msgtype > EC_AIO_MSG_NUL) { //最多处理_msgbudget个消息,剩下得在doRecvBuffer中处理。
+					if (domsgs(kfd, msg, msgtype, zview) < 0)
 						return -1;
 				}
 				if (msgtype == EC_AIO_MSG_ERR) {
-					_plog->add(CLOG_DEFAULT_ERR, "fd(%d) read error message.", pss->_fd);
+					_plog->add(CLOG_DEFAULT_ERR, "fd(%d) read error message.", kfd);
 					return -1;
 				}
 				return postsend(kfd) < 0 ? -1 : 0;
@@ -506,6 +719,9 @@ namespace ec {
 			virtual void onAccept(int fd, const char* sip, uint16_t port, int fdlisten)
 			{
 				setkeepalive(fd);
+#if EC_AIO_TCP_NODELAY
+				tcpnodelay(fd);
+#endif
 				psession pss = new session(&_sndbufblks, fd, fdlisten);
 				if (!pss)
 					return;
@@ -520,6 +736,37 @@ namespace ec {
 				_allsend += size;
 				_bpsSnd.add(ec::mstime(), (int64_t)size);
 			}
+#ifndef _WIN32
+			void sendpost_(t_postmsg& msg)
+			{
+				if (sendtofd(msg._fd, msg._data.data(), msg._data.size()) < 0)
+					_plog->add(CLOG_DEFAULT_DBG, "fd(%d) send posted message failed.", msg._fd);
+			}
+
+			virtual void onWakeup()
+			{
+				_postq.unsignal(); // posts after here will wakeup again
+				for (;;) {
+					ec::queue<t_postmsg> msgs;
+					if (_postovf.load(std::memory_order_acquire)) {
+						ec::unique_lock lck(&_postlck);
+						msgs.swap(_postmsgs);
+						if (msgs.empty())
+							_postovf.store(0, std::memory_order_release);
+					}
+					// the ring before the overflow, messages in the ring are older than the overflow from the same thread
+					size_t nmax = msgs.empty() ? _postq.capacity() : SIZE_MAX;
+					if (_postq.pop_n([this](t_postmsg& msg) { sendpost_(msg); }, nmax) == nmax) {
+						if (_postq.signal()) // more left, come back after other events
+							wakeup();
+					}
+					if (msgs.empty())
+						break;
+					for (auto& msg : msgs)
+						sendpost_(msg);
+				}
+			}
+#endif
 
 			virtual int onReceivedFrom(int kfd, const void* pdata, size_t size, const struct sockaddr* addrfrom, int addrlen) {				
 				_allrecv += size;
@@ -527,5 +774,140 @@ namespace ec {
 				return 0;
 			}
 		};
+
+#ifndef _WIN32
+		/**
+		 * @brief multi-reactor, N epoll threads, each reactor is a _Srv with its own epoll and session map.
+		 *  all reactors listen the same port with SO_REUSEPORT, the kernel shards connections across them.
+		 * @tparam _Srv class derived from ec::aio::netserver
+		 * @remark kfd % size() is the owner reactor id of kfd, use sendtofd() to send from any thread.
+		 *  the ec::ilog used by reactors must be thread safe.
+		*/
+		template<class _Srv>
+		class netreactors
+		{
+		protected:
+			class reactor_ : public ec::thread
+			{
+			public:
+				_Srv* _psrv;
+				int _waitmsec;
+				reactor_(_Srv* psrv) : _psrv(psrv), _waitmsec(100) {
+				}
+				virtual ~reactor_() {
+					threadStop();
+					if (_psrv) {
+						_psrv->close();
+						delete _psrv;
+						_psrv = nullptr;
+					}
+				}
+			protected:
+				virtual void threadRuntime()
+				{
+					int64_t currentmsec = 0;
+					_psrv->runtime(_waitmsec, currentmsec);
+				}
+			};
+			ec::vector<reactor_*> _reactors;
+		public:
+			netreactors() {
+			}
+			virtual ~netreactors() {
+				close();
+			}
+
+			/**
+			 * @brief create reactors and open epoll
+			 * @param numreactors number of reactors, usually the number of cpu cores.
+			 * @param args arguments of _Srv constructor
+			 * @return true: success
+			*/
+			template<class... Args>
+			bool open(int numreactors, Args&&... args)
+			{
+				if (!_reactors.empty() || numreactors < 1)
+					return false;
+				_reactors.reserve(numreactors);
+				for (int i = 0; i < numreactors; i++) {
+					_Srv* psrv = new _Srv(args...);
+					psrv->setfdspace(i, numreactors);
+					_reactors.push_back(new reactor_(psrv));
+					if (psrv->open() < 0) {
+						close();
+						return false;
+					}
+				}
+				return true;
+			}
+
+			/**
+			 * @brief every reactor listen on the same port with SO_REUSEPORT, call before start()
+			 * @return number of reactors listen success; -1:failed
+			*/
+			int tcplisten(uint16_t port, const char* sip = nullptr, int ipv6only = 0)
+			{
+				int n = 0;
+				for (auto& i : _reactors) {
+					if (i->_psrv->tcplisten(port, sip, ipv6only, 1) < 0)
+						return -1;
+					++n;
+				}
+				return n;
+			}
+
+			bool start(int waitmsec = 100)
+			{
+				for (auto& i : _reactors) {
+					i->_waitmsec = waitmsec;
+					if (!i->threadRunning() && !i->threadStart())
+						return false;
+				}
+				return true;
+			}
+
+			void stop()
+			{
+				for (auto& i : _reactors)
+					i->threadStop();
+			}
+
+			void close()
+			{
+				for (auto& i : _reactors)
+					delete i;
+				_reactors.clear();
+			}
+
+			inline size_t size() const
+			{
+				return _reactors.size();
+			}
+
+			inline _Srv* at(size_t n)
+			{
+				return n < _reactors.size() ? _reactors[n]->_psrv : nullptr;
+			}
+
+			inline _Srv* owner(int fd) // the reactor which owns fd
+			{
+				if (fd < 0 || _reactors.empty())
+					return nullptr;
+				return _reactors[fd % _reactors.size()]->_psrv;
+			}
+
+			/**
+			 * @brief thread safe send, post to the owner reactor of fd.
+			 * @return 0: posted; -1: error
+			*/
+			int sendtofd(int fd, const void* pdata, size_t size)
+			{
+				_Srv* psrv = owner(fd);
+				if (!psrv)
+					return -1;
+				return psrv->postsendtofd(fd, pdata, size);
+			}
+		};
+#endif
 	}//namespace aio
 }//namespace ec
\ No newline at end of file
@@ -6,6 +6,16 @@ http/ws server
 \author  jiangyong
 
 \update 
+  2026-10-17 cached 200 responses send the Server head, Vary: Accept-Encoding for all compressible cached files
+  2026-10-17 httpserver override domessageview, http requests processed by dohttp as a view in _rbuf without copy
+  2026-10-17 dohttp parse in stream mode only if enable_bodystream()
+  2026-10-17 cached compressible files send Vary: Accept-Encoding, document the file cache is per reactor
+  2026-10-17 linux download big file and range open and check the file before send the head, reply 404/500 if failed
+  2026-10-17 add httpchunkhead(), httpchunk() and httpchunked() for response of unknown length, dohttp parse in stream mode
+  2026-10-17 add ETag and Last-Modified to static files, If-None-Match/If-Modified-Since reply 304 without reading the file
+  2026-10-17 add httpfilecache, LRU cache of static files with gzip compressed once, stat-on-interval invalidation
+  2026-10-17 httpwrite and the response heads use ec::astring/abytes from the session arena
+  2026-10-17 linux download big file and range only send the head, the content sent by the session send job (sendfile)
   2023-12-25 fix http Security vulnerability
   2023-5-30 support multi http root path
   2023-5-23 update http rang download big file
@@ -34,8 +44,252 @@ You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2
 #endif
 #endif
 
+#ifndef EC_HTTP_FILECACHE_SIZE // bytes of the static file cache (raw + gzip) of one httpserver, 0: no cache. netreactors use N times
+#if defined(_MEM_TINY) // < 256M
+#define EC_HTTP_FILECACHE_SIZE (1024 * 1024 * 4)
+#elif defined(_MEM_SML) // < 1G
+#define EC_HTTP_FILECACHE_SIZE (1024 * 1024 * 16)
+#else
+#define EC_HTTP_FILECACHE_SIZE (1024 * 1024 * 64)
+#endif
+#endif
+
+#ifndef EC_HTTP_FILECACHE_MAXFILE
+#define EC_HTTP_FILECACHE_MAXFILE (HTTP_RANGE_SIZE * 16) // files larger than it are not cached, same as the downbigfile limit
+#endif
+
+#ifndef EC_HTTP_FILECACHE_CHECKMS
+#define EC_HTTP_FILECACHE_CHECKMS 2000 // stat a cached file at most once in this interval, reload if size or mtime changed
+#endif
+
 namespace ec {
 	namespace aio {
+		/**
+		 * @brief LRU cache of static files for httpserver, key is the resolved file path.
+		 *  holds the raw bytes, the gzip bytes (compressed once when loaded), the mime type, size and mtime.
+		 *  not thread safe, each httpserver (reactor) has its own, netreactors with N reactors use up to N * EC_HTTP_FILECACHE_SIZE,
+		 *  call filecache().setconfig() of each reactor to share a total size.
+		 *  compressible files send "Vary: Accept-Encoding" in the gzip and the identity responses.
+		*/
+		class httpfilecache
+		{
+		public:
+			struct t_stats {
+				uint64_t hits; // served from cache
+				uint64_t misses; // not in cache, or changed
+				uint64_t reloads; // changed on disk, dropped
+				uint64_t evicts; // dropped by LRU
+				size_t files;
+				size_t bytes;
+			};
+			struct t_file {
+				ec::string _path;
+				ec::bytes _raw;
+				ec::bytes _gzip; // empty: not compressed
+				char _mime[80];
+				char _etag[40];
+				char _validators[160]; // "ETag: ...\r\nLast-Modified: ...\r\n" if made, and "Vary: Accept-Encoding\r\n" if _gzip not empty
+				long long _size;
+				time_t _mtime;
+				int64_t _mschecked; // last stat time
+				t_file* _prev; // newer
+				t_file* _next; // older
+			};
+		protected:
+			struct keq_file {
+				bool operator()(const char* key, t_file* val)
+				{
+					return ec::streq(key, val->_path.c_str());
+				}
+			};
+			struct del_file {
+				void operator()(t_file*& val)
+				{
+					if (val) {
+						delete val;
+						val = nullptr;
+					}
+				}
+			};
+			ec::flatmap<const char*, t_file*, keq_file, del_file> _map;
+			t_file* _phead; // the newest
+			t_file* _ptail; // the oldest
+			size_t _capacity;
+			size_t _maxfile;
+			int _checkms;
+			t_stats _stats;
+
+			inline size_t fsize_(const t_file* pf) const
+			{
+				return pf->_raw.size() + pf->_gzip.size();
+			}
+			void unlink_(t_file* pf)
+			{
+				if (pf->_prev)
+					pf->_prev->_next = pf->_next;
+				else
+					_phead = pf->_next;
+				if (pf->_next)
+					pf->_next->_prev = pf->_prev;
+				else
+					_ptail = pf->_prev;
+				pf->_prev = pf->_next = nullptr;
+			}
+			void pushfront_(t_file* pf)
+			{
+				pf->_prev = nullptr;
+				pf->_next = _phead;
+				if (_phead)
+					_phead->_prev = pf;
+				else
+					_ptail = pf;
+				_phead = pf;
+			}
+			void remove_(t_file* pf)
+			{
+				unlink_(pf);
+				_stats.bytes -= fsize_(pf);
+				--_stats.files;
+				_map.erase(pf->_path.c_str()); // delete pf
+			}
+		public:
+			httpfilecache(const httpfilecache&) = delete;
+			httpfilecache& operator = (const httpfilecache&) = delete;
+			httpfilecache(size_t capacity = EC_HTTP_FILECACHE_SIZE, size_t maxfile = EC_HTTP_FILECACHE_MAXFILE, int checkms = EC_HTTP_FILECACHE_CHECKMS)
+				: _map(512), _phead(nullptr), _ptail(nullptr), _capacity(capacity), _maxfile(maxfile), _checkms(checkms)
+			{
+				memset(&_stats, 0, sizeof(_stats));
+			}
+			~httpfilecache()
+			{
+				clear();
+			}
+
+			/**
+			 * @brief make the entity tag and the validator heads "ETag: ...\r\nLast-Modified: ...\r\n" of a file
+			*/
+			static bool mkvalidators(long long size, time_t mtime, char* setag, size_t etagsize, char* shead, size_t headsize)
+			{
+				char sgmt[40];
+				if (!ec::http::etagstring(size, mtime, setag, etagsize) || !ec::http::gmtstring(mtime, sgmt, sizeof(sgmt)))
+					return false;
+				int n = snprintf(shead, headsize, "ETag: %s\r\nLast-Modified: %s\r\n", setag, sgmt);
+				return n > 0 && n < (int)headsize;
+			}
+			void setconfig(size_t capacity, size_t maxfile, int checkms)
+			{
+				_capacity = capacity;
+				_maxfile = maxfile;
+				_checkms = checkms;
+				while (_ptail && _stats.bytes > _capacity) {
+					remove_(_ptail);
+					++_stats.evicts;
+				}
+			}
+			inline const t_stats& stats() const
+			{
+				return _stats;
+			}
+			void clear()
+			{
+				_map.clear();
+				_phead = _ptail = nullptr;
+				_stats.files = 0;
+				_stats.bytes = 0;
+			}
+
+			/**
+			 * @brief find a cached file, stat the file if not checked in EC_HTTP_FILECACHE_CHECKMS.
+			 * @return nullptr: not cached or changed on disk; the pointer is valid until next load()
+			*/
+			const t_file* find(const char* sfile)
+			{
+				if (!_capacity || !_phead)
+					return nullptr;
+				t_file** ppf = _map.get(sfile);
+				if (!ppf)
+					return nullptr;
+				t_file* pf = *ppf;
+				int64_t mscur = ec::mstime();
+				if (mscur - pf->_mschecked >= _checkms || mscur < pf->_mschecked) {
+					t_stat st;
+					if (!ec::io::filestat(sfile, &st) || st.bdir || st.size != pf->_size || st.mtime != pf->_mtime) {
+						remove_(pf);
+						++_stats.reloads;
+						return nullptr;
+					}
+					pf->_mschecked = mscur;
+				}
+				if (pf != _phead) {
+					unlink_(pf);
+					pushfront_(pf);
+				}
+				++_stats.hits;
+				return pf;
+			}
+
+			/**
+			 * @brief read the file into cache, gzip it once if bzip, evict the least recently used files over capacity.
+			 * @param smime mime type, nullptr or "" for application/octet-stream
+			 * @return nullptr: not cacheable (too large or read failed)
+			*/
+			const t_file* load(const char* sfile, const char* smime, bool bzip)
+			{
+				++_stats.misses;
+				if (!_capacity)
+					return nullptr;
+				t_stat st;
+				if (!ec::io::filestat(sfile, &st) || st.bdir || st.size <= 0 || (size_t)st.size > _maxfile || (size_t)st.size > _capacity)
+					return nullptr;
+				t_file** ppf = _map.get(sfile);
+				if (ppf)
+					remove_(*ppf);
+				t_file* pf = new t_file;
+				if (!pf)
+					return nullptr;
+				pf->_path = sfile;
+				pf->_prev = pf->_next = nullptr;
+				pf->_mschecked = ec::mstime();
+				if (!ec::io::lckread(sfile, &pf->_raw, 0, 0, st.size) || (long long)pf->_raw.size() != st.size) {
+					delete pf;
+					return nullptr;
+				}
+				pf->_size = st.size;
+				pf->_mtime = st.mtime;
+				if (!mkvalidators(pf->_size, pf->_mtime, pf->_etag, sizeof(pf->_etag), pf->_validators, sizeof(pf->_validators))) {
+					pf->_etag[0] = 0;
+					pf->_validators[0] = 0;
+				}
+				ec::strlcpy(pf->_mime, smime && *smime ? smime : "application/octet-stream", sizeof(pf->_mime));
+				if (bzip && pf->_raw.size() > 512) {
+					pf->_gzip.reserve(pf->_raw.size() / 2);
+					if (Z_OK != ec::http::package::encode_body(pf->_raw.data(), pf->_raw.size(), &pf->_gzip, true)
+						|| pf->_gzip.size() >= pf->_raw.size()) {
+						pf->_gzip.clear();
+						pf->_gzip.shrink_to_fit();
+					}
+				}
+				if (!pf->_gzip.empty()) { // the body depends on Accept-Encoding, also 304 and HEAD
+					const char* svary = "Vary: Accept-Encoding\r\n";
+					size_t zv = strlen(pf->_validators);
+					if (zv + strlen(svary) < sizeof(pf->_validators))
+						memcpy(pf->_validators + zv, svary, strlen(svary) + 1);
+				}
+				while (_ptail && _stats.bytes + fsize_(pf) > _capacity) {
+					remove_(_ptail);
+					++_stats.evicts;
+				}
+				if (!_map.set(pf->_path.c_str(), pf)) {
+					delete pf;
+					return nullptr;
+				}
+				pushfront_(pf);
+				_stats.bytes += fsize_(pf);
+				++_stats.files;
+				return pf;
+			}
+		};
+
 		class httpserver : public netserver
 		{
 		public:
@@ -56,6 +310,7 @@ namespace ec {
 			ec::mimecfg* _pmine;
 			char _pathhttp[512];//utf8, http documents root path. The last character is '/'
 			ec::hashmap<const char*, i_root, keq_rootnode> _roots;
+			httpfilecache _filecache; // static files, used by downfile, one cache per httpserver (reactor)
 		public:
 			httpserver(ec::ilog* plog, ec::mimecfg* pmine) :
 				ec::aio::netserver(plog)
@@ -89,6 +344,10 @@ namespace ec {
 				ec::formatpath(it._path);
 				_roots.set(sname, std::move(it));
 			}
+			inline httpfilecache& filecache() // for stats and setconfig, e.g. EC_HTTP_FILECACHE_SIZE / number of reactors
+			{
+				return _filecache;
+			}
 			template<class _STR = std::string>
 			bool getRootPath(const char* src, _STR& sout)
 			{
@@ -122,6 +381,17 @@ namespace ec {
 			{
 				return false;
 			}
+
+			/**
+			 * @brief http requests are processed by dohttp as a view in the session _rbuf without copy,
+			 *  other messages are copied to domessage. Override it to process http requests in the application layer.
+			*/
+			virtual int domessageview(int fd, const uint8_t* pmsg, size_t msgsize, int msgtype)
+			{
+				if (EC_AIO_MSG_HTTP == msgtype)
+					return dohttp(fd, pmsg, msgsize) ? 0 : -1;
+				return netserver::domessageview(fd, pmsg, msgsize, msgtype);
+			}
 			void loghttpstartline(int nlevel, int fd, const char* s, size_t size) //output http start line to log
 			{
 				if (!this->_plog || nlevel > this->_plog->getlevel())
@@ -140,19 +410,64 @@ namespace ec {
 			 * @return
 			*/
 			bool httpwrite(int fd, ec::http::package* pPkg, int statuscode, const char* statusinfo,
-				const char* body, size_t sizebody, const char* sContentType, bool bzip = true)
+				const char* body, size_t sizebody, const char* sContentType, bool bzip = true, const char* sheads = nullptr)
 			{
-				ec::bytes vs;
+				ec::abytes vs;
 				vs.reserve(1024 + sizebody);
-				if (!pPkg->make(&vs, statuscode, statusinfo, sContentType, "Accept-Ranges: bytes\r\n", body, sizebody, bzip))
+				ec::str256 heads;
+				heads.append("Accept-Ranges: bytes\r\n");
+				if (sheads && *sheads)
+					heads.append(sheads);
+				if (!pPkg->make(&vs, statuscode, statusinfo, sContentType, heads.c_str(), body, sizebody, bzip))
+					return false;
+				return this->sendtofd(fd, vs.data(), vs.size()) >= 0;
+			}
+			/**
+			 * @brief send response head of chunked transfer coding, then send the body by httpchunk()
+			*/
+			bool httpchunkhead(int fd, ec::http::package* pPkg, int statuscode, const char* statusinfo,
+				const char* sContentType, const char* sheads = nullptr)
+			{
+				ec::astring vs;
+				vs.reserve(512);
+				if (!pPkg->makechunked(&vs, statuscode, statusinfo, sContentType, sheads))
 					return false;
 				return this->sendtofd(fd, vs.data(), vs.size()) >= 0;
 			}
+
+			/**
+			 * @brief send a chunk of the response body after httpchunkhead()
+			 * @param size 0: the last chunk, end of body
+			*/
+			bool httpchunk(int fd, const void* pdata, size_t size)
+			{
+				ec::abytes vs;
+				vs.reserve(size + 32);
+				ec::http::chunk(&vs, pdata, size);
+				return this->sendtofd(fd, vs.data(), vs.size()) >= 0;
+			}
+
+			/**
+			 * @brief send response of chunked transfer coding, the body read from psrc when the session send buffer is empty
+			 * @param psrc new created body source, the session own it
+			*/
+			bool httpchunked(int fd, ec::http::package* pPkg, int statuscode, const char* statusinfo,
+				const char* sContentType, ec::aio::httpbodysource* psrc, const char* sheads = nullptr)
+			{
+				ec::aio::session* ps = getsession(fd);
+				if (!ps) {
+					delete psrc;
+					return false;
+				}
+				if (!ps->setHttpBodySource(psrc))
+					return false;
+				return httpchunkhead(fd, pPkg, statuscode, statusinfo, sContentType, sheads);
+			}
 			void loghttphead(int loglevel, const char* sinfo, ec::ilog* plog, ec::http::package* ph) //output http heade to log
 			{
 				if (plog->getlevel() < loglevel)
 					return;
-				ec::string vs;
+				ec::astring vs;
 				vs.reserve(2000);
 				for (auto& i : ph->_head) {
 					vs += '\t';
@@ -180,19 +495,37 @@ namespace ec {
 					lposend = atoll(send);
 				return true;
 			}
-			bool DoHead(int fd, const char* sfile, ec::http::package* pPkg)
+			/**
+			 * @brief 304 Not Modified, only the heads
+			 * @param svalidators "ETag: ...\r\nLast-Modified: ...\r\n"
+			*/
+			bool DoNotModified(int fd, ec::http::package* pPkg, const char* svalidators)
+			{
+				ec::astring answer;
+				answer.reserve(400);
+				answer += "HTTP/1.1 304 Not Modified\r\nServer: eclib web server\r\n";
+				if (pPkg->HasKeepAlive())
+					answer += "Connection: keep-alive\r\n";
+				if (svalidators)
+					answer += svalidators;
+				answer += "\r\n";
+				return this->sendtofd(fd, answer.data(), answer.size()) >= 0;
+			}
+			bool DoHead(int fd, const char* sfile, ec::http::package* pPkg, const char* svalidators = nullptr)
 			{
 				ec::str256 tmp;
 				long long flen = ec::io::filesize(sfile);
 				if (flen < 0) {
 					return httpwrite(fd, pPkg, 404, "not fund", html_404, strlen(html_404), "text/html");
 				}
-				ec::string answer;
+				ec::astring answer;
 				answer.reserve(4000);
 				answer += "HTTP/1.1 200 ok\r\nServer: eclib web server\r\n";
 				if (pPkg->HasKeepAlive())
 					answer += "Connection: keep-alive\r\n";
 				answer += "Accept-Ranges: bytes\r\n";
+				if (svalidators)
+					answer += svalidators;
 				if (!tmp.format("Content-Length: %lld\r\n\r\n", flen))
 					return false;
 				answer.append(tmp.data(), tmp.size());
@@ -200,17 +533,38 @@ namespace ec {
 					this->_plog->add(CLOG_DEFAULT_DBG, "http head write fd(%u) size %zu :\n%s", fd, answer.size(), answer.c_str());
 				return this->sendtofd(fd, answer.data(), answer.size()) >= 0;
 			}
-			bool downfile(int fd, ec::http::package* pPkg, const char* sfile)
+			bool downcache(int fd, ec::http::package* pPkg, const httpfilecache::t_file* pf)
 			{
-				ec::string data;
-				if (!ec::io::lckread(sfile, &data) || !data.size()) {
-					return httpwrite(fd, pPkg, 404, "not fund", html_404, strlen(html_404), "text/html");
-				}
 				ec::aio::session* ps = getsession(fd);
 				if (!ps)
 					return false;
 				if (ps->hasSendJob())
 					ps->setHttpDownFile(nullptr, 0, 0);
+				int ncode = pPkg->accept_encoding();
+				if (1 == ncode && !pf->_gzip.empty()) // deflate only, compress per request
+					return httpwrite(fd, pPkg, 200, "ok", (const char*)pf->_raw.data(), pf->_raw.size(), pf->_mime, true, pf->_validators);
+				const ec::bytes& body = (2 == ncode && !pf->_gzip.empty()) ? pf->_gzip : pf->_raw;
+				ec::str256 tmp;
+				ec::abytes vs;
+				vs.reserve(400 + body.size());
+				vs.append("HTTP/1.1 200 ok\r\nServer: eclib web server\r\n");
+				if (pPkg->HasKeepAlive())
+					vs.append("Connection: keep-alive\r\n");
+				vs.append("Accept-Ranges: bytes\r\n");
+				if (!tmp.format("Content-type: %s\r\n", pf->_mime))
+					return false;
+				vs.append(tmp.data(), tmp.size());
+				if (&body == &pf->_gzip)
+					vs.append("Content-Encoding: gzip\r\n");
+				vs.append(pf->_validators);
+				if (!tmp.format("Content-Length: %zu\r\n\r\n", body.size()))
+					return false;
+				vs.append(tmp.data(), tmp.size());
+				vs.append(body.data(), body.size());
+				return this->sendtofd(fd, vs.data(), vs.size()) >= 0;
+			}
+			bool downfile(int fd, ec::http::package* pPkg, const char* sfile, const char* svalidators = nullptr)
+			{
 				const char* sext = ec::http::file_extname(sfile);
 				ec::str256 content_type;
 				bool bzip = true;
@@ -218,15 +572,60 @@ namespace ec {
 					_pmine->getmime(sext, content_type);
 					bzip = !ec::http::iszipfile(sext);
 				}
-				return httpwrite(fd, pPkg, 200, "ok", data.data(), data.size(), content_type.c_str(), bzip);
+				const httpfilecache::t_file* pf = _filecache.load(sfile, content_type.c_str(), bzip);
+				if (pf)
+					return downcache(fd, pPkg, pf);
+				ec::string data;
+				if (!ec::io::lckread(sfile, &data) || !data.size()) {
+					return httpwrite(fd, pPkg, 404, "not fund", html_404, strlen(html_404), "text/html");
+				}
+				ec::aio::session* ps = getsession(fd);
+				if (!ps)
+					return false;
+				if (ps->hasSendJob())
+					ps->setHttpDownFile(nullptr, 0, 0);
+				return httpwrite(fd, pPkg, 200, "ok", data.data(), data.size(), content_type.c_str(), bzip, svalidators);
 			}
-			bool downbigfile(int fd, http::package* pPkg, const char* sfile, long long filelen)
+#ifndef _WIN32
+			/*!
+			\brief open the download file before the response head is sent, the file size must still be filelen
+			\return the file fd, the session own it by setHttpDownFd(); -1: failed and 404 or 500 replied, see bret
+			*/
+			int opendownfile(int fd, http::package* pPkg, const char* sfile, long long filelen, bool& bret)
+			{
+				int fdfile = ::open(sfile, O_RDONLY | O_CLOEXEC);
+				if (fdfile < 0) {
+					bret = httpwrite(fd, pPkg, 404, "not fund", html_404, strlen(html_404), "text/html");
+					return -1;
+				}
+				struct stat st;
+				if (fstat(fdfile, &st) || (long long)st.st_size != filelen) {
+					::close(fdfile);
+					if (_plog)
+						_plog->add(CLOG_DEFAULT_WRN, "fd(%d) http down file '%s' size changed", fd, sfile);
+					bret = httpwrite(fd, pPkg, 500, "Internal Server Error", html_500, strlen(html_500), "text/html");
+					return -1;
+				}
+				return fdfile;
+			}
+#endif
+			bool downbigfile(int fd, http::package* pPkg, const char* sfile, long long filelen, const char* svalidators = nullptr)
 			{
 				if (filelen <= HTTP_RANGE_SIZE) {
-					return downfile(fd, pPkg, sfile);
+					return downfile(fd, pPkg, sfile, svalidators);
 				}
-				ec::string data, sContent;
+#ifndef _WIN32
+				bool bret = false;
+				int fdfile = opendownfile(fd, pPkg, sfile, filelen, bret);
+				if (fdfile < 0)
+					return bret;
+#endif
+				ec::astring data, sContent;
+#ifdef _WIN32
 				data.reserve(HTTP_RANGE_SIZE + 400);
+#else
+				data.reserve(400);
+#endif
 				data = "HTTP/1.1 200 ok\r\nServer: eclib3 web server\r\n";
 				data += "Connection: keep-alive\r\nAccept-Ranges: bytes\r\n";
 
@@ -236,24 +635,36 @@ namespace ec {
 				}
 				else
 					data += "Content-type: application/octet-stream\r\n";
+				if (svalidators)
+					data += svalidators;
 				data.append("Content-Length: ").append(ec::to_string(filelen)).append("\r\n\r\n");
-
+#ifdef _WIN32
 				if (!ec::io::lckread(sfile, &data, 0, HTTP_RANGE_SIZE, filelen)) {
 					return httpwrite(fd, pPkg, 404, "not fund", html_404, strlen(html_404), "text/html");
 				}
+#endif
 				if (_plog)
 					_plog->add(CLOG_DEFAULT_DBG, "fd(%u) http down file '%s', Content-Length=%lld",
 						fd, sfile, filelen);
 				ec::aio::session* ps = getsession(fd);
+#ifdef _WIN32
 				if (!ps)
 					return false;
 				ps->setHttpDownFile(sfile, HTTP_RANGE_SIZE, filelen);
+#else
+				if (!ps) {
+					::close(fdfile);
+					return false;
+				}
+				ps->setHttpDownFd(fdfile, sfile, 0, filelen); // the whole content sent by the session send job
+#endif
 				return sendtofd(fd, data.data(), data.size()) >= 0;
 			}
-			bool DoGetRang(int fd, const char* sfile, ec::http::package* pPkg, int64_t lpos, int64_t lposend, int64_t lfilesize)
+			bool DoGetRang(int fd, const char* sfile, ec::http::package* pPkg, int64_t lpos, int64_t lposend, int64_t lfilesize,
+				const char* svalidators = nullptr)
 			{
 				str1k tmp;
-				ec::string answer;
+				ec::astring answer;
 				if (lpos >= lposend || lposend + 1 > lfilesize) {
 					answer.reserve(512);
 					answer += "HTTP/1.1 416 Range Not Satisfiable\r\nServer: eclib web server\r\n";
@@ -264,7 +675,15 @@ namespace ec {
 					return sendtofd(fd, answer.data(), answer.size()) >= 0;
 				}
 				int64_t sizeContent = lposend - lpos + 1;
+#ifdef _WIN32
 				answer.reserve(HTTP_RANGE_SIZE + 512);
+#else
+				bool bret = false;
+				int fdfile = opendownfile(fd, pPkg, sfile, lfilesize, bret);
+				if (fdfile < 0)
+					return bret;
+				answer.reserve(512);
+#endif
 				answer += "HTTP/1.1 206 Partial Content\r\nServer: eclib web server\r\n";
 				if (pPkg->HasKeepAlive())
 					answer += "Connection: keep-alive\r\n";
@@ -277,32 +696,46 @@ namespace ec {
 				}
 				else
 					answer += "Content-type: application/octet-stream\r\n";
+				if (svalidators)
+					answer += svalidators;
 				if (!tmp.format("Content-Range: bytes %jd-%jd/%jd\r\n", lpos, (lpos + sizeContent - 1), lfilesize))
 					return false;
 				answer.append(tmp);
 				if (!tmp.format("Content-Length: %jd\r\n\r\n", sizeContent))
 					return false;
 				answer += tmp;
+#ifdef _WIN32
 				int64_t lread = sizeContent > HTTP_RANGE_SIZE ? HTTP_RANGE_SIZE : sizeContent;
 				if (!io::lckread(sfile, &answer, lpos, lread, lfilesize)) {
 					return httpwrite(fd, pPkg, 404, "not fund", html_404, strlen(html_404), "text/html");
 				}
+#else
+				int64_t lread = 0; // the rang content sent by the session send job from lpos
+#endif
 				if (_plog)
 					_plog->add(CLOG_DEFAULT_DBG, "fd(%d) http down file '%s' Content-Length=%jd rang %jd-%jd/%jd", 
 						fd, sfile, sizeContent, lpos, (lpos + sizeContent - 1), lfilesize);
 				ec::aio::session* ps = getsession(fd);
+#ifdef _WIN32
 				if (!ps)
 					return false;
 				if (lpos + lread < lposend + 1)
 					ps->setHttpDownFile(sfile, lpos + lread, lposend + 1);
 				else
 					ps->setHttpDownFile(nullptr, 0, 0);
+#else
+				if (!ps) {
+					::close(fdfile);
+					return false;
+				}
+				ps->setHttpDownFd(fdfile, sfile, lpos + lread, lposend + 1);
+#endif
 				return sendtofd(fd, answer.data(), answer.size()) >= 0;
 			}
 			bool dohttp(int fd, const uint8_t* pkg, size_t pkgsize)
 			{
 				ec::http::package http;
-				if (http.parse(((const char*)pkg), pkgsize) <= 0)
+				if (http.parse(((const char*)pkg), pkgsize, enable_bodystream()) <= 0)
 					return false;
 				if (doAppHttp(http))
 					return true;
@@ -331,16 +764,34 @@ namespace ec {
 				}
 				else
 					sfile.append(utf8.data(), utf8.size());
-				if (sfile.back() == '/')
+				bool bdir = sfile.back() == '/';
+				if (bdir)
 					sfile += "index.html";
-				else if (ec::http::isdir(sfile.c_str()))
+				const httpfilecache::t_file* pf = _filecache.find(sfile.c_str()); // no disk access if cached and checked recently
+				if (!pf && !bdir && ec::http::isdir(sfile.c_str()))
 					sfile += "/index.html";
-				long long flen = ec::io::filesize(sfile.c_str());
+				long long flen = -1;
+				time_t mtime = 0;
+				t_stat st;
+				if (pf) {
+					flen = pf->_size;
+					mtime = pf->_mtime;
+				}
+				else if (ec::io::filestat(sfile.c_str(), &st)) {
+					flen = st.size;
+					mtime = st.mtime;
+				}
 				if (flen < 0) {
 					return httpwrite(fd, &http, 404, "not fund", html_404, strlen(html_404), "text/html");
 				}
+				char setag[40], svalid[128];
+				const char* pvalid = pf ? pf->_validators : nullptr;
+				if (!pf && httpfilecache::mkvalidators(flen, mtime, setag, sizeof(setag), svalid, sizeof(svalid)))
+					pvalid = svalid;
+				if (pvalid && *pvalid && (!pf || pf->_etag[0]) && http.notmodified(pf ? pf->_etag : setag, mtime))
+					return DoNotModified(fd, &http, pvalid);
 				if (http.ismethod("HEAD"))
-					return DoHead(fd, sfile.c_str(), &http);
+					return DoHead(fd, sfile.c_str(), &http, pvalid);
 
 				utf8.clear();
 				if (http.GetHeadFiled("Range", utf8)) { // "Range: bytes=0-1023" or "Range: bytes=0-"
@@ -350,11 +801,13 @@ namespace ec {
 					}
 					if (rangposend <= 0)
 						rangposend = flen - 1;
-					return DoGetRang(fd, sfile.c_str(), &http, rangpos, rangposend, flen);
+					return DoGetRang(fd, sfile.c_str(), &http, rangpos, rangposend, flen, pvalid);
 				}
+				if (pf)
+					return downcache(fd, &http, pf);
 				if (flen > HTTP_RANGE_SIZE * 16)
-					return downbigfile(fd, &http, sfile.c_str(), flen);
-				return downfile(fd, &http, sfile.c_str());
+					return downbigfile(fd, &http, sfile.c_str(), flen, pvalid);
+				return downfile(fd, &http, sfile.c_str(), pvalid);
 			}
 		};
 	}//namespace aio
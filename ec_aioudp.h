@@ -0,0 +1,183 @@
+﻿/*!
+\file ec_aioudp.h
+
+eclib3 AIO
+udp receive and send in batches with recvmmsg/sendmmsg, shared by serverepoll_ and serveruring_
+
+\author  jiangyong
+\update
+  2026-10-17 first version, moved from ec_netepoll.h and ec_neturing.h
+
+eclib 3.0 Copyright (c) 2017-2023, kipway
+Licensed under the Apache License, Version 2.0 (the "License");
+You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*/
+
+#pragma once
+
+#include "ec_aiolinux.h"
+#include "ec_aiosession.h"
+#include "ec_log.h"
+
+#ifndef EC_AIO_UDP_BATCH
+#define EC_AIO_UDP_BATCH 16 // datagrams per recvmmsg/sendmmsg, max 4 batches per event
+#endif
+
+#ifndef EC_AIO_UDP_MSGSIZE
+#define EC_AIO_UDP_MSGSIZE (1024 * 64) // receive buffer size of each datagram in batch
+#endif
+
+namespace ec {
+	namespace aio {
+		class udpbatch_
+		{
+		private:
+			struct t_msgs { // recvmmsg buffers, malloc at the first receive
+				struct mmsghdr hdrs[EC_AIO_UDP_BATCH];
+				struct iovec iovs[EC_AIO_UDP_BATCH];
+				struct sockaddr_storage addrs[EC_AIO_UDP_BATCH];
+				char bufs[EC_AIO_UDP_BATCH][EC_AIO_UDP_MSGSIZE];
+			};
+			t_msgs* _pmsgs;
+
+			t_msgs* msgs_()
+			{
+				if (!_pmsgs) {
+					_pmsgs = (t_msgs*)malloc(sizeof(t_msgs));
+					if (!_pmsgs)
+						return nullptr;
+					for (auto i = 0; i < EC_AIO_UDP_BATCH; i++) {
+						_pmsgs->iovs[i].iov_base = _pmsgs->bufs[i];
+						_pmsgs->iovs[i].iov_len = EC_AIO_UDP_MSGSIZE;
+					}
+				}
+				for (auto i = 0; i < EC_AIO_UDP_BATCH; i++) {
+					memset(&_pmsgs->hdrs[i], 0, sizeof(_pmsgs->hdrs[i]));
+					_pmsgs->hdrs[i].msg_hdr.msg_name = &_pmsgs->addrs[i];
+					_pmsgs->hdrs[i].msg_hdr.msg_namelen = sizeof(_pmsgs->addrs[i]);
+					_pmsgs->hdrs[i].msg_hdr.msg_iov = &_pmsgs->iovs[i];
+					_pmsgs->hdrs[i].msg_hdr.msg_iovlen = 1;
+				}
+				return _pmsgs;
+			}
+		public:
+			udpbatch_() : _pmsgs(nullptr)
+			{
+			}
+			~udpbatch_()
+			{
+				if (_pmsgs) {
+					free(_pmsgs);
+					_pmsgs = nullptr;
+				}
+			}
+
+			/**
+			 * @brief receive datagrams, max 4 batches
+			 * @param net
+			 * @param kfd keyfd of udp
+			 * @param plog
+			 * @param fun int(const void* pdata, size_t size, const struct sockaddr* addrfrom, int addrlen), return -1 stop receiving
+			*/
+			template<class _Fun>
+			void recvfrom(netio_linux& net, int kfd, ec::ilog* plog, _Fun fun)
+			{
+				int i, nr = -1, ndo = 4;
+				t_msgs* pmsgs;
+				do {
+					if (!(pmsgs = msgs_()))
+						break;
+					nr = net.recvmmsg_(kfd, pmsgs->hdrs, EC_AIO_UDP_BATCH);
+					if (nr < 0) {
+						if (EAGAIN != errno)
+							plog->add(CLOG_DEFAULT_ERR, "fd(%d) recvmmsg failed. error %d", kfd, errno);
+						break;
+					}
+					for (i = 0; i < nr; i++) {
+						struct msghdr& msg = pmsgs->hdrs[i].msg_hdr;
+						if (!pmsgs->hdrs[i].msg_len)
+							continue;
+						if (msg.msg_flags & MSG_TRUNC)
+							plog->add(CLOG_DEFAULT_WRN, "fd(%d) datagram truncated to %u bytes.", kfd, pmsgs->hdrs[i].msg_len);
+#ifdef _DEBUG
+						if (plog->getlevel() >= CLOG_DEFAULT_ALL) {
+							ec::net::socketaddr addr;
+							addr.set((const struct sockaddr*)msg.msg_name, (int)msg.msg_namelen);
+							plog->add(CLOG_DEFAULT_ALL, "fd(%d) recvfrom %s:%u %u bytes.", kfd,
+								addr.viewip(), addr.port(), pmsgs->hdrs[i].msg_len);
+						}
+#endif
+						if (fun(pmsgs->bufs[i], pmsgs->hdrs[i].msg_len,
+							(const struct sockaddr*)msg.msg_name, (int)msg.msg_namelen) < 0) {
+							nr = 0;
+							break;
+						}
+					}
+					--ndo;
+				} while (nr == EC_AIO_UDP_BATCH && ndo > 0);
+			}
+
+			/**
+			 * @brief send frames in batches, max 4 batches. sent frames are popped, EAGAIN keep the frame and send again later
+			 * @param net
+			 * @param kfd keyfd of udp
+			 * @param pfrms frames wait send
+			 * @param plog
+			 * @param nbytes [out] bytes sent
+			 * @param funfail void(udp_frm_& frm, int errcode), sendmmsg failed not EAGAIN, the frame is popped after
+			 * @return number of datagrams sent
+			*/
+			template<class _Fun>
+			int sendto(netio_linux& net, int kfd, udb_buffer_* pfrms, ec::ilog* plog, int& nbytes, _Fun funfail)
+			{
+				struct mmsghdr hdrs[EC_AIO_UDP_BATCH];
+				struct iovec iovs[EC_AIO_UDP_BATCH];
+				int i, n, ns, numsnd = 0, nbatch = 0;
+				nbytes = 0;
+				do {
+					while (!pfrms->empty() && pfrms->front().empty())
+						pfrms->pop();
+					n = 0;
+					for (auto& frm : *pfrms) {
+						if (n >= EC_AIO_UDP_BATCH || frm.empty())
+							break;
+						iovs[n].iov_base = frm.data();
+						iovs[n].iov_len = frm.size();
+						memset(&hdrs[n], 0, sizeof(hdrs[n]));
+						hdrs[n].msg_hdr.msg_name = (void*)frm.getnetaddr();
+						hdrs[n].msg_hdr.msg_namelen = frm.netaddrlen();
+						hdrs[n].msg_hdr.msg_iov = &iovs[n];
+						hdrs[n].msg_hdr.msg_iovlen = 1;
+						++n;
+					}
+					if (!n)
+						break;
+					ns = net.sendmmsg_(kfd, hdrs, n);
+					if (ns < 0) {
+						if (EAGAIN != errno) {
+							funfail(pfrms->front(), errno);
+							pfrms->pop();
+						}
+						break;
+					}
+					for (i = 0; i < ns; i++) {
+#ifdef _DEBUG
+						if (plog->getlevel() >= CLOG_DEFAULT_ALL) {
+							ec::net::socketaddr peeraddr;
+							peeraddr.set(pfrms->front().getnetaddr(), pfrms->front().netaddrlen());
+							plog->add(CLOG_DEFAULT_ALL, "fd(%d) sento %s:%u %zu bytes.", kfd,
+								peeraddr.viewip(), peeraddr.port(), pfrms->front().size());
+						}
+#endif
+						nbytes += (int)pfrms->front().size();
+						pfrms->pop();
+					}
+					numsnd += ns;
+					if (ns < n) // system buffer full
+						break;
+				} while (!pfrms->empty() && ++nbatch < 4);
+				return numsnd;
+			}
+		};
+	}//namespace aio
+}//namespace ec
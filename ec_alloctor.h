@@ -2,7 +2,17 @@
 \file ec_alloctor.h
 \author	jiangyong
 \email  kipway@outlook.com
-\update 2023.7.25
+\update
+  2026.10.17 arena::inscope check the arenas of all scopes in the stack
+  2026.10.17 call sites sampled at the public malloc_/realloc_, not inlined if EC_ALLOCTOR_STATS
+  2026.10.17 ~allocator detach the thread local caches of all threads, caches linked to their owner
+  2026.10.17 add arena, bump allocator for objects scoped to one message or session, ec::arena::scope and arena_allocator
+  2026.10.17 realloc_ grow geometrically across size classes, big system blocks use mmap and grow by mremap (EC_ALLOCTOR_MREMAP)
+  2026.10.17 add allocator statistics getstats()/stats_tojson() and call site sampling (EC_ALLOCTOR_STATS)
+  2026.10.17 add opt-in mmap arena for big heaps (EC_ALLOCTOR_MMAP), huge pages, NUMA node bind, idle heaps return pages by MADV_DONTNEED
+  2026.10.17 blk_alloctor keep heaps with free blocks and full heaps in two lists, O(1) malloc and free
+  2026.10.17 add thread local cache (magazines) in front of each blk_alloctor, batch refill and return
+  2023.7.25
 
 memory
 	eclib memory allocator for ec::string, ec::hashmap, and other small objects etc.
@@ -56,6 +66,10 @@ namespace ec {
 #define EC_ALLOCTOR_ALIGN 8u
 #endif
 
+#ifndef EC_ARENA_CHUNKSIZE // ec::arena chunk size, fit the 8K block of ec::allocator
+#define EC_ARENA_CHUNKSIZE (8 * 1024 - EC_ALLOCTOR_ALIGN)
+#endif
+
 #ifndef EC_ALLOCTOR_SHEAP_SIZE  // small heap size
 #if defined(_MEM_TINY) // < 256M
 #define EC_ALLOCTOR_SHEAP_SIZE (128 * 1024) // 128K heap size
@@ -100,6 +114,108 @@ namespace ec {
 #define EC_SIZE_BLK_ALLOCATOR 32
 #endif
 
+#ifndef EC_ALLOCTOR_MMAP // 1: heaps not less than EC_ALLOCTOR_MMAP_MINSIZE use mmap arena instead of malloc, linux only
+#define EC_ALLOCTOR_MMAP 0
+#endif
+#if defined(_WIN32) && EC_ALLOCTOR_MMAP
+#undef EC_ALLOCTOR_MMAP
+#define EC_ALLOCTOR_MMAP 0
+#endif
+
+#if EC_ALLOCTOR_MMAP
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#ifndef EC_ALLOCTOR_MMAP_MINSIZE // min heap bytes use mmap
+#define EC_ALLOCTOR_MMAP_MINSIZE (1024 * 1024)
+#endif
+
+#ifndef EC_ALLOCTOR_HUGEPAGE_SIZE // arena size and address aligned to huge page
+#define EC_ALLOCTOR_HUGEPAGE_SIZE (2 * 1024 * 1024)
+#endif
+
+#ifndef EC_ALLOCTOR_MMAP_HUGETLB // 1: try explicit huge pages (MAP_HUGETLB) first; 0: transparent huge pages (MADV_HUGEPAGE)
+#define EC_ALLOCTOR_MMAP_HUGETLB 0
+#endif
+
+#ifndef EC_ALLOCTOR_MMAP_NUMA // 1: prefer the NUMA node of the calling thread (mbind MPOL_PREFERRED)
+#define EC_ALLOCTOR_MMAP_NUMA 0
+#endif
+
+#ifndef EC_ALLOCTOR_MMAP_IDLE // max idle arenas per blk_alloctor, pages returned by MADV_DONTNEED, address space kept for the next heap
+#define EC_ALLOCTOR_MMAP_IDLE 2
+#endif
+#endif
+
+#ifndef EC_ALLOCTOR_STATS // 1: count alloc/free/realloc copy and bytes per size class, sample call sites by setsample()
+#define EC_ALLOCTOR_STATS 0
+#endif
+
+#if EC_ALLOCTOR_STATS
+#include <atomic>
+#ifndef EC_ALLOCTOR_SAMPLE_SITES // max call sites recorded
+#define EC_ALLOCTOR_SAMPLE_SITES 256
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#define EC_ALLOCTOR_RETADDR() _ReturnAddress()
+#define EC_ALLOCTOR_NOINLINE __declspec(noinline)
+#else
+#define EC_ALLOCTOR_RETADDR() __builtin_return_address(0)
+#define EC_ALLOCTOR_NOINLINE __attribute__((noinline))
+#endif
+#endif
+
+#ifdef _WIN32
+#include <malloc.h>
+#define EC_ALLOCTOR_SYSSIZE(p) _msize(p)
+#else
+#define EC_ALLOCTOR_SYSSIZE(p) malloc_usable_size(p)
+#endif
+
+#ifndef EC_ALLOCTOR_MREMAP // 1: system blocks not less than EC_ALLOCTOR_MREMAP_MINSIZE use mmap, realloc by mremap without copy
+#ifdef __linux__
+#define EC_ALLOCTOR_MREMAP 1
+#else
+#define EC_ALLOCTOR_MREMAP 0
+#endif
+#endif
+
+#if EC_ALLOCTOR_MREMAP
+#include <unistd.h>
+#include <sys/mman.h>
+#ifndef EC_ALLOCTOR_MREMAP_MINSIZE
+#define EC_ALLOCTOR_MREMAP_MINSIZE (1024 * 1024)
+#endif
+#endif
+
+#ifndef EC_ALLOCTOR_TCACHE // thread local cache of blocks, 0:disable
+#define EC_ALLOCTOR_TCACHE 1
+#endif
+
+#if EC_ALLOCTOR_TCACHE
+#include <atomic>
+#endif
+
+#ifndef EC_ALLOCTOR_TCACHE_BATCH // max blocks of one batch refill from or return to the shared blk_alloctor
+#if defined(_MEM_TINY) // < 256M
+#define EC_ALLOCTOR_TCACHE_BATCH 8
+#else
+#define EC_ALLOCTOR_TCACHE_BATCH 16
+#endif
+#endif
+
+#ifndef EC_ALLOCTOR_TCACHE_BYTES // max bytes of one batch, size of block > EC_ALLOCTOR_TCACHE_BYTES/2 not cached
+#if defined(_MEM_TINY) // < 256M
+#define EC_ALLOCTOR_TCACHE_BYTES (8 * 1024)
+#elif defined(_MEM_SML) // < 1G
+#define EC_ALLOCTOR_TCACHE_BYTES (16 * 1024)
+#else
+#define EC_ALLOCTOR_TCACHE_BYTES (32 * 1024)
+#endif
+#endif
+
 namespace ec {
 	class null_lock final // null lock
 	{
@@ -184,10 +300,12 @@ namespace ec{
 		size_t _numblk;//number of all blocks
 		size_t _sizeblk;// size of block bytes
 		char* _pmem;// memory allocated from the system
+		size_t _sizemap; // mmap arena size, 0: _pmem malloc from the system
 		t_blk* _phead; // head block pointer of list
 		void* _palloc; //blk_alloctor for release optimization
 	public:
 		memheap_* _pnext;
+		memheap_* _pprev;
 
 		inline size_t numfree() {
 			return _numfree;
@@ -205,18 +323,27 @@ namespace ec{
 			return _palloc;
 		}
 
+		inline bool ismmap() const { // memory is a mmap arena
+			return _sizemap != 0;
+		}
+
 		static void* operator new(size_t size);
 		static void operator delete(void* p);
 		static void* operator new(size_t size, void* ptr) { return ptr; }
 		static void operator delete(void* ptr, void* voidptr2) noexcept {}
 	public:
-		memheap_(void* palloc) :_numfree(0), _numblk(0), _sizeblk(0), _pmem(nullptr),
-			_phead(nullptr), _palloc(palloc), _pnext(nullptr)
+		memheap_(void* palloc) :_numfree(0), _numblk(0), _sizeblk(0), _pmem(nullptr), _sizemap(0),
+			_phead(nullptr), _palloc(palloc), _pnext(nullptr), _pprev(nullptr)
 		{
 		}
 		~memheap_()
 		{
 			if (_pmem) {
+#if EC_ALLOCTOR_MMAP
+				if (_sizemap)
+					::munmap(_pmem, _sizemap);
+				else
+#endif
 				::free(_pmem);
 				_pmem = nullptr;
 				_phead = nullptr;
@@ -231,12 +358,73 @@ namespace ec{
 		{
 			if (sizeblk % EC_ALLOCTOR_ALIGN)
 				sizeblk += (EC_ALLOCTOR_ALIGN - sizeblk % EC_ALLOCTOR_ALIGN);
-			_pmem = (char*)::malloc(numblk * (sizeblk + EC_ALLOCTOR_ALIGN));
+			size_t zmem = numblk * (sizeblk + EC_ALLOCTOR_ALIGN);
+#if EC_ALLOCTOR_MMAP
+			if (zmem >= EC_ALLOCTOR_MMAP_MINSIZE)
+				_pmem = mmaparena(zmem, &_sizemap);
+			if (!_pmem)
+#endif
+			_pmem = (char*)::malloc(zmem);
 			if (!_pmem)
 				return false;
 			_sizeblk = sizeblk;
 			_numblk = numblk;
+			initblks();
+			return true;
+		}
 
+#if EC_ALLOCTOR_MMAP
+		/*!
+		\brief return all pages of an idle mmap arena to the OS, the address space kept, call initblks() before reuse
+		\return false if not a mmap arena or not all blocks free
+		*/
+		bool purge()
+		{
+			if (!_sizemap || _numfree != _numblk)
+				return false;
+			if (::madvise(_pmem, _sizemap, MADV_DONTNEED))
+				return false;
+			_phead = nullptr;
+			_numfree = 0;
+			return true;
+		}
+
+		static char* mmaparena(size_t zmem, size_t* psizemap)
+		{
+			const size_t zhuge = EC_ALLOCTOR_HUGEPAGE_SIZE;
+			size_t zmap = (zmem + zhuge - 1) / zhuge * zhuge;
+			char* p = (char*)MAP_FAILED;
+#if EC_ALLOCTOR_MMAP_HUGETLB
+			p = (char*)::mmap(nullptr, zmap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+			if (MAP_FAILED == p) { // over map then trim to huge page aligned, transparent huge pages need aligned address
+				char* pm = (char*)::mmap(nullptr, zmap + zhuge, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+				if (MAP_FAILED == pm)
+					return nullptr;
+				p = (char*)(((uintptr_t)pm + zhuge - 1) & ~(uintptr_t)(zhuge - 1));
+				if (p > pm)
+					::munmap(pm, p - pm);
+				if (pm + zmap + zhuge > p + zmap)
+					::munmap(p + zmap, (pm + zmap + zhuge) - (p + zmap));
+#ifdef MADV_HUGEPAGE
+				::madvise(p, zmap, MADV_HUGEPAGE);
+#endif
+			}
+#if EC_ALLOCTOR_MMAP_NUMA
+			unsigned int ucpu = 0, unode = 0;
+			if (!syscall(SYS_getcpu, &ucpu, &unode, nullptr) && unode < 8 * sizeof(unsigned long)) {
+				unsigned long nodemask = 1ul << unode;
+				syscall(SYS_mbind, p, zmap, 1 /*MPOL_PREFERRED*/, &nodemask, 8 * sizeof(unsigned long), 0);
+			}
+#endif
+			*psizemap = zmap;
+			return p;
+		}
+#endif
+
+		void initblks() // link all blocks to the free list
+		{
+			size_t numblk = _numblk, sizeblk = _sizeblk;
 			char* ps = _pmem;
 			sizeblk += EC_ALLOCTOR_ALIGN;
 
@@ -250,7 +438,6 @@ namespace ec{
 			}
 			_phead = reinterpret_cast<t_blk*>(_pmem + EC_ALLOCTOR_ALIGN);
 			_numfree = _numblk;
-			return true;
 		}
 
 		void* malloc_(size_t size)
@@ -287,13 +474,30 @@ namespace ec{
 	class blk_alloctor final  // memory block alloctor
 	{
 	protected:
-		memheap_* _phead;
+		memheap_* _phead; // heaps with free blocks, the head is the current heap for malloc, all free heaps at the tail
+		memheap_* _ptail;
+		memheap_* _pfull; // heaps without free block
+#if EC_ALLOCTOR_MMAP
+		memheap_* _pidle; // purged mmap arenas for reuse
+		int32_t _numidle;
+#endif
 		LOCK _lck;
 		int32_t _numheaps; // 堆个数，用于辅助释放空闲堆
 		int32_t _numfreeblks; // 空闲内存块数,用于快速增加堆
 		uint32_t _sizeblk; // 内存块的大小，构造或者初始化时设定,EC_ALLOCTOR_ALIGN字节对齐.
 		uint32_t _numblksperheap; //每个堆里的内存块个数
+		uint32_t _id; // index in ec::allocator, for thread local cache
 	public:
+		inline uint32_t getid() const
+		{
+			return _id;
+		}
+
+		inline void setid(uint32_t id)
+		{
+			_id = id;
+		}
+
 		inline int32_t numheaps() const
 		{
 			return _numheaps;
@@ -316,19 +520,33 @@ namespace ec{
 
 		blk_alloctor() :
 			_phead(nullptr),
+			_ptail(nullptr),
+			_pfull(nullptr),
+#if EC_ALLOCTOR_MMAP
+			_pidle(nullptr),
+			_numidle(0),
+#endif
 			_numheaps(0),
 			_numfreeblks(0),
 			_sizeblk(0),
-			_numblksperheap(0)
+			_numblksperheap(0),
+			_id(0)
 		{
 		}
 
 		blk_alloctor(size_t sizeblk, size_t numblk) :
 			_phead(nullptr),
+			_ptail(nullptr),
+			_pfull(nullptr),
+#if EC_ALLOCTOR_MMAP
+			_pidle(nullptr),
+			_numidle(0),
+#endif
 			_numheaps(0),
 			_numfreeblks(0),
 			_sizeblk(0),
-			_numblksperheap(0)
+			_numblksperheap(0),
+			_id(0)
 		{
 			init(sizeblk, numblk);
 		}
@@ -340,7 +558,25 @@ namespace ec{
 				delete p;
 				p = pn;
 			}
+			p = _pfull;
+			while (p) {
+				pn = p->_pnext;
+				delete p;
+				p = pn;
+			}
+#if EC_ALLOCTOR_MMAP
+			p = _pidle;
+			while (p) {
+				pn = p->_pnext;
+				delete p;
+				p = pn;
+			}
+			_pidle = nullptr;
+			_numidle = 0;
+#endif
 			_phead = nullptr;
+			_ptail = nullptr;
+			_pfull = nullptr;
 			_numheaps = 0;
 			_numfreeblks = 0;
 			_sizeblk = 0;
@@ -367,6 +603,7 @@ namespace ec{
 				_phead = nullptr;
 				return false;
 			}
+			_ptail = _phead;
 			_sizeblk = (uint32_t)_phead->sizeblk();
 			_numblksperheap = (uint32_t)numblk;
 			_numheaps = 1;
@@ -377,44 +614,20 @@ namespace ec{
 		void* malloc_(size_t size, size_t* poutsize)
 		{
 			safe_lock<LOCK> lck(&_lck);
-			memheap_* pheap;
-			if (!_numfreeblks) {
-				pheap = new memheap_(this);
-				if (!pheap)
-					return nullptr;
-				if (!pheap->init(_sizeblk, _numblksperheap)) {
-					delete pheap;
-					return nullptr;
-				}
-				pheap->_pnext = _phead;
-				_phead = pheap;
-				_numheaps++;
-				_numfreeblks += (int32_t)(_numblksperheap - 1);
-				if (poutsize)
-					*poutsize = _sizeblk;
-				return _phead->malloc_(size);
-			}
+			return malloc_nolock_(size, poutsize);
+		}
 
-			void* pret = nullptr;
-			memheap_* pprior = nullptr;
-			pheap = _phead;
-			while (pheap) {
-				if (nullptr != (pret = pheap->malloc_(size))) {
-					_numfreeblks--;
-					if (poutsize)
-						*poutsize = _sizeblk;
-					if (pprior && pheap->numfree() > 0) { // move to head for next fast malloc
-						pprior->_pnext = pheap->_pnext;
-						pheap->_pnext = _phead;
-						_phead = pheap;
-					}
-					return pret;
-				}
-				pprior = pheap;
-				pheap = pheap->_pnext;
-			}
-			assert(pret != nullptr);
-			return nullptr;
+		/*!
+		\brief batch malloc blocks for thread local cache, lock once
+		\return number of blocks malloced into pout
+		*/
+		int malloc_batch(void** pout, int num)
+		{
+			safe_lock<LOCK> lck(&_lck);
+			int n = 0;
+			while (n < num && nullptr != (pout[n] = malloc_nolock_(_sizeblk, nullptr)))
+				n++;
+			return n;
 		}
 
 		bool free_(void* p)// for single allotor such as ec::hashmap
@@ -426,11 +639,7 @@ namespace ec{
 			}
 			_lck.lock();
 			assert((*pheap)->getalloc() == this);
-			(*pheap)->free_(p);
-			_numfreeblks++;
-			if (_numheaps > EC_ALLOCTOR_GC_MINHEAPS && (*pheap)->canfree() && (*pheap) != _phead 
-				&& _numfreeblks % (int32_t)_numblksperheap)//防止不断整块分配和释放
-				gc_();
+			free_nolock_(*pheap, p);
 			_lck.unlock();
 			return true;
 		}
@@ -438,15 +647,22 @@ namespace ec{
 		bool free_(memheap_* pheap, void* p) // for multiple allotor
 		{
 			_lck.lock();
-			pheap->free_(p);
-			_numfreeblks++;
-			if (_numheaps > EC_ALLOCTOR_GC_MINHEAPS && pheap->canfree() && pheap != _phead 
-				&& _numfreeblks % (int32_t)_numblksperheap)//防止不断整块分配和释放
-				gc_();
+			free_nolock_(pheap, p);
 			_lck.unlock();
 			return true;
 		}
 
+		/*!
+		\brief batch free blocks from thread local cache, lock once
+		*/
+		void free_batch(void** pblks, int num)
+		{
+			_lck.lock();
+			for (int i = 0; i < num; i++)
+				free_nolock_(*(memheap_**)(static_cast<char*>(pblks[i]) - EC_ALLOCTOR_ALIGN), pblks[i]);
+			_lck.unlock();
+		}
+
 		size_t numfree() // for debug
 		{
 			safe_lock<LOCK> lck(&_lck);
@@ -460,36 +676,452 @@ namespace ec{
 		}
 
 	private:
-		int gc_() //garbage collection
+		void* malloc_nolock_(size_t size, size_t* poutsize)
+		{
+			memheap_* pheap = _phead;
+			if (!pheap) {
+#if EC_ALLOCTOR_MMAP
+				if (_pidle) { // reuse the address space of an idle arena
+					pheap = _pidle;
+					_pidle = pheap->_pnext;
+					_numidle--;
+					pheap->initblks();
+				}
+				else
+#endif
+				{
+					pheap = new memheap_(this);
+					if (!pheap)
+						return nullptr;
+					if (!pheap->init(_sizeblk, _numblksperheap)) {
+						delete pheap;
+						return nullptr;
+					}
+				}
+				pushhead_(&_phead, &_ptail, pheap);
+				_numheaps++;
+				_numfreeblks += (int32_t)_numblksperheap;
+			}
+			void* pret = pheap->malloc_(size);
+			assert(pret != nullptr);
+			_numfreeblks--;
+			if (pheap->empty()) { // move to the full list
+				unlink_(&_phead, &_ptail, pheap);
+				pushhead_(&_pfull, nullptr, pheap);
+			}
+			if (poutsize)
+				*poutsize = _sizeblk;
+			return pret;
+		}
+
+		void free_nolock_(memheap_* pheap, void* p)
+		{
+			bool bfull = pheap->empty();
+			pheap->free_(p);
+			_numfreeblks++;
+			if (bfull) { // back to the head of heaps with free blocks, next malloc use it
+				unlink_(&_pfull, nullptr, pheap);
+				pushhead_(&_phead, &_ptail, pheap);
+			}
+			if (!pheap->canfree())
+				return;
+			if (pheap != _ptail) { // free heap move to the tail, malloc from the used heaps first
+				unlink_(&_phead, &_ptail, pheap);
+				pushtail_(pheap);
+			}
+			if (_numheaps > EC_ALLOCTOR_GC_MINHEAPS && pheap != _phead // the head heap is never freed, it stops thrashing
+				&& (pheap->ismmap() // mmap arena for predictable RSS, idle arenas reused cheaply
+					|| _numfreeblks % (int32_t)_numblksperheap)//防止不断整块分配和释放
+				)
+				gc_();
+		}
+
+		void unlink_(memheap_** phead, memheap_** ptail, memheap_* p)
+		{
+			if (p->_pprev)
+				p->_pprev->_pnext = p->_pnext;
+			else
+				*phead = p->_pnext;
+			if (p->_pnext)
+				p->_pnext->_pprev = p->_pprev;
+			else if (ptail)
+				*ptail = p->_pprev;
+			p->_pprev = nullptr;
+			p->_pnext = nullptr;
+		}
+
+		void pushhead_(memheap_** phead, memheap_** ptail, memheap_* p)
+		{
+			p->_pprev = nullptr;
+			p->_pnext = *phead;
+			if (*phead)
+				(*phead)->_pprev = p;
+			else if (ptail)
+				*ptail = p;
+			*phead = p;
+		}
+
+		void pushtail_(memheap_* p)
+		{
+			p->_pnext = nullptr;
+			p->_pprev = _ptail;
+			if (_ptail)
+				_ptail->_pnext = p;
+			else
+				_phead = p;
+			_ptail = p;
+		}
+
+		int gc_() //garbage collection, free heaps are at the tail
 		{
 			int n = 0;
-			memheap_* p = _phead; //_phead永远不会被回收
-			memheap_* pnext;
-			if (!p)
-				return n;
-			pnext = p->_pnext;
-			while (pnext) {
-				if (pnext->canfree()) {
-					p->_pnext = pnext->_pnext;
-					delete pnext;
-					_numheaps--;
-					_numfreeblks -= (int)(_numblksperheap);
-					n++;
+			memheap_* p;
+			while (nullptr != (p = _ptail) && p != _phead && p->canfree()) { //_phead永远不会被回收
+				unlink_(&_phead, &_ptail, p);
+#if EC_ALLOCTOR_MMAP
+				if (_numidle < EC_ALLOCTOR_MMAP_IDLE && p->purge()) {
+					p->_pnext = _pidle;
+					_pidle = p;
+					_numidle++;
 				}
 				else
-					p = pnext;
-				pnext = p->_pnext;
+#endif
+				delete p;
+				_numheaps--;
+				_numfreeblks -= (int)(_numblksperheap);
+				n++;
 			}
 			return n;
 		}
 	};
 
+	struct allocstat_ // statistics of one size class
+	{
+		size_t sizeblk; // 0: malloc from system, size > maxblksize()
+		int32_t numheaps;
+		int32_t numfreeblks; // not include blocks in the thread local caches
+		uint64_t nalloc; // all counters are 0 if EC_ALLOCTOR_STATS is 0
+		uint64_t nfree;
+		uint64_t ncopy; // realloc_ malloc new block and copy
+		int64_t curbytes; // bytes in use, block size for size classes
+		int64_t peakbytes;
+
+		template<class _STR>
+		void tojson(_STR& sout) const // compatible with ec::js::out_jobject/out_jobj_array
+		{
+			char s[400];
+			int n = snprintf(s, sizeof(s), "{\"sizeblk\":%zu,\"heaps\":%d,\"freeblks\":%d,\"alloc\":%llu,\"free\":%llu,"
+				"\"copy\":%llu,\"curbytes\":%lld,\"peakbytes\":%lld}", sizeblk, numheaps, numfreeblks,
+				(unsigned long long)nalloc, (unsigned long long)nfree, (unsigned long long)ncopy,
+				(long long)curbytes, (long long)peakbytes);
+			if (n > 0 && n < (int)sizeof(s))
+				sout.append(s, n);
+		}
+	};
+
+	struct allocsite_ // sampled call site
+	{
+		const void* addr; // return address of the allocator caller
+		uint64_t count; // sampled times
+		uint64_t bytes; // sampled bytes
+
+		template<class _STR>
+		void tojson(_STR& sout) const
+		{
+			char s[160];
+			int n = snprintf(s, sizeof(s), "{\"addr\":\"%p\",\"count\":%llu,\"bytes\":%llu}",
+				addr, (unsigned long long)count, (unsigned long long)bytes);
+			if (n > 0 && n < (int)sizeof(s))
+				sout.append(s, n);
+		}
+	};
+
 	class allocator final
 	{
 	protected:
 		using PA_ = blk_alloctor<spinlock>*;
 		unsigned int _size;
 		PA_ _alloctors[EC_SIZE_BLK_ALLOCATOR];
+#if EC_ALLOCTOR_TCACHE
+		struct t_mag // magazine of one blk_alloctor
+		{
+			int num; // number of cached blocks
+			int nbatch; // blocks of one batch, 0: not cached
+			void* blks[EC_ALLOCTOR_TCACHE_BATCH * 2];
+		};
+		struct t_tcache // thread local cache, no destructor, valid until the thread exit
+		{
+			std::atomic<allocator*> powner; // cleared by ~allocator of the owner, maybe in another thread
+			t_tcache* pnext; // next cache of the same owner, linked under tclck_()
+			int bexit; // thread exiting, no more cache
+			t_mag mags[EC_SIZE_BLK_ALLOCATOR];
+		};
+		t_tcache* _tcs; // caches of all threads use this allocator
+		struct t_tcguard // return the cached blocks to the shared blk_alloctor at thread exit
+		{
+			~t_tcguard()
+			{
+				t_tcache* ptc = tcache_();
+				safe_lock<spinlock> lck(&tclck_());
+				allocator* pa = ptc->powner.load(std::memory_order_relaxed);
+				if (pa) {
+					pa->flushtc_(ptc);
+					pa->unlinktc_(ptc);
+				}
+				ptc->bexit = 1;
+			}
+		};
+
+		static t_tcache* tcache_()
+		{
+			static thread_local t_tcache tc; // zero initialized
+			return &tc;
+		}
+
+		static spinlock& tclck_() // lock of the links between caches and allocators
+		{
+			static spinlock* plck = new spinlock; // never deleted, threads may exit after the static destructors
+			return *plck;
+		}
+
+		t_tcache* mytcache_() // cache of the calling thread, nullptr: not use cache
+		{
+			t_tcache* ptc = tcache_();
+			allocator* pa = ptc->powner.load(std::memory_order_relaxed);
+			if (pa == this)
+				return ptc;
+			if (pa || ptc->bexit) // only one allocator per thread use cache
+				return nullptr;
+			static thread_local t_tcguard guard;
+			(void)guard;
+			for (auto i = 0u; i < _size; i++) {
+				size_t n = EC_ALLOCTOR_TCACHE_BYTES / _alloctors[i]->sizeblk();
+				ptc->mags[i].num = 0;
+				ptc->mags[i].nbatch = n < 2u ? 0 : (n > EC_ALLOCTOR_TCACHE_BATCH ? EC_ALLOCTOR_TCACHE_BATCH : (int)n);
+			}
+			safe_lock<spinlock> lck(&tclck_());
+			ptc->pnext = _tcs;
+			_tcs = ptc;
+			ptc->powner.store(this, std::memory_order_relaxed);
+			return ptc;
+		}
+
+		void unlinktc_(t_tcache* ptc) // under tclck_()
+		{
+			for (t_tcache** pp = &_tcs; *pp; pp = &(*pp)->pnext) {
+				if (*pp == ptc) {
+					*pp = ptc->pnext;
+					break;
+				}
+			}
+			ptc->pnext = nullptr;
+			ptc->powner.store(nullptr, std::memory_order_relaxed);
+		}
+
+		void flushtc_(t_tcache* ptc)
+		{
+			for (auto i = 0u; i < _size; i++) {
+				if (ptc->mags[i].num) {
+					_alloctors[i]->free_batch(ptc->mags[i].blks, ptc->mags[i].num);
+					ptc->mags[i].num = 0;
+				}
+			}
+		}
+#endif
+#if EC_ALLOCTOR_STATS
+		struct t_stat
+		{
+			std::atomic<uint64_t> nalloc;
+			std::atomic<uint64_t> nfree;
+			std::atomic<uint64_t> ncopy;
+			std::atomic<int64_t> curbytes;
+			std::atomic<int64_t> peakbytes;
+		};
+		t_stat _stats[EC_SIZE_BLK_ALLOCATOR + 1]; // the last for system malloc
+		std::atomic<uint32_t> _sampleevery; // 0: no sample
+		std::atomic<uint32_t> _samplecount;
+		allocsite_ _sites[EC_ALLOCTOR_SAMPLE_SITES]; // open addressing by addr
+		spinlock _sitelck;
+
+		t_stat* stat_(size_t i) {
+			return &_stats[i < _size ? i : EC_SIZE_BLK_ALLOCATOR];
+		}
+
+		void stat_alloc_(size_t i, int64_t bytes, const void* paddr)
+		{
+			t_stat* ps = stat_(i);
+			ps->nalloc.fetch_add(1, std::memory_order_relaxed);
+			int64_t cur = ps->curbytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+			int64_t peak = ps->peakbytes.load(std::memory_order_relaxed);
+			while (cur > peak && !ps->peakbytes.compare_exchange_weak(peak, cur, std::memory_order_relaxed))
+				;
+			uint32_t every = _sampleevery.load(std::memory_order_relaxed);
+			if (every && !(_samplecount.fetch_add(1, std::memory_order_relaxed) % every))
+				sample_(paddr, bytes);
+		}
+
+		void stat_free_(size_t i, int64_t bytes)
+		{
+			t_stat* ps = stat_(i);
+			ps->nfree.fetch_add(1, std::memory_order_relaxed);
+			ps->curbytes.fetch_sub(bytes, std::memory_order_relaxed);
+		}
+
+		void sample_(const void* paddr, int64_t bytes)
+		{
+			size_t h = ((size_t)paddr >> 2) % EC_ALLOCTOR_SAMPLE_SITES;
+			safe_lock<spinlock> lck(&_sitelck);
+			for (auto n = 0; n < EC_ALLOCTOR_SAMPLE_SITES; n++) {
+				allocsite_* pi = &_sites[(h + n) % EC_ALLOCTOR_SAMPLE_SITES];
+				if (!pi->addr)
+					pi->addr = paddr;
+				if (pi->addr == paddr) {
+					pi->count++;
+					pi->bytes += (uint64_t)bytes;
+					return;
+				}
+			}
+		}
+#endif
+		static memheap_* mapmark_() // header of the system block by mmap
+		{
+			return reinterpret_cast<memheap_*>((uintptr_t)1u);
+		}
+
+		static bool issysblk_(memheap_* pheap)
+		{
+			return !pheap || pheap == mapmark_();
+		}
+
+		static size_t syssize_(void* p) // capacity of the system block
+		{
+			char* pb = reinterpret_cast<char*>(p) - EC_ALLOCTOR_ALIGN;
+#if EC_ALLOCTOR_MREMAP
+			if (*reinterpret_cast<memheap_**>(pb) == mapmark_())
+				return *reinterpret_cast<size_t*>(pb - EC_ALLOCTOR_ALIGN) - 2 * EC_ALLOCTOR_ALIGN;
+#endif
+			return EC_ALLOCTOR_SYSSIZE(pb) - EC_ALLOCTOR_ALIGN;
+		}
+
+		static void* sysmalloc_(size_t size, size_t* psize)
+		{
+#if EC_ALLOCTOR_MREMAP
+			if (size >= EC_ALLOCTOR_MREMAP_MINSIZE)
+				return mapremap_(nullptr, size, psize);
+#endif
+			char* pb = (char*)::malloc(size + EC_ALLOCTOR_ALIGN);
+			if (!pb)
+				return nullptr;
+			*reinterpret_cast<memheap_**>(pb) = nullptr;
+			if (psize)
+				*psize = size;
+			return pb + EC_ALLOCTOR_ALIGN;
+		}
+
+		static void sysfree_(void* p)
+		{
+			char* pb = reinterpret_cast<char*>(p) - EC_ALLOCTOR_ALIGN;
+#if EC_ALLOCTOR_MREMAP
+			if (*reinterpret_cast<memheap_**>(pb) == mapmark_()) {
+				pb -= EC_ALLOCTOR_ALIGN;
+				::munmap(pb, *reinterpret_cast<size_t*>(pb));
+				return;
+			}
+#endif
+			::free(pb);
+		}
+
+		/*!
+		\brief realloc the system block, grow at least 1.5 times, shrink only if less than 1/4
+		\return new pointer, nullptr if failed and p is still valid
+		*/
+		static void* sysrealloc_(void* p, size_t size, size_t* psize)
+		{
+			size_t zold = syssize_(p);
+			if (size <= zold && size >= zold / 4) {
+				if (psize)
+					*psize = zold;
+				return p;
+			}
+			size_t znew = size;
+			if (size > zold && size < zold + zold / 2)
+				znew = zold + zold / 2;
+#if EC_ALLOCTOR_MREMAP
+			if (*reinterpret_cast<memheap_**>(reinterpret_cast<char*>(p) - EC_ALLOCTOR_ALIGN) == mapmark_())
+				return mapremap_(p, znew, psize);
+			if (znew >= EC_ALLOCTOR_MREMAP_MINSIZE) { // copy once, grow by mremap later
+				void* pnew = mapremap_(nullptr, znew, psize);
+				if (!pnew)
+					return nullptr;
+				memcpy(pnew, p, zold);
+				sysfree_(p);
+				return pnew;
+			}
+#endif
+			char* pb = (char*)::realloc(reinterpret_cast<char*>(p) - EC_ALLOCTOR_ALIGN, znew + EC_ALLOCTOR_ALIGN);
+			if (!pb)
+				return nullptr;
+			if (psize)
+				*psize = znew;
+			return pb + EC_ALLOCTOR_ALIGN;
+		}
+
+#if EC_ALLOCTOR_MREMAP
+		/*!
+		\brief mmap (p is nullptr) or mremap the system block. head: [size_t mapsize][memheap_* mapmark_()]
+		*/
+		static void* mapremap_(void* p, size_t size, size_t* psize)
+		{
+			static_assert(EC_ALLOCTOR_ALIGN >= sizeof(size_t), "EC_ALLOCTOR_ALIGN too small");
+			static const size_t zpage = (size_t)sysconf(_SC_PAGESIZE);
+			size_t zmap = (size + 2 * EC_ALLOCTOR_ALIGN + zpage - 1) / zpage * zpage;
+			char* pb;
+			if (p) {
+				pb = reinterpret_cast<char*>(p) - 2 * EC_ALLOCTOR_ALIGN;
+				pb = (char*)::mremap(pb, *reinterpret_cast<size_t*>(pb), zmap, MREMAP_MAYMOVE);
+			}
+			else
+				pb = (char*)::mmap(nullptr, zmap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (MAP_FAILED == pb)
+				return nullptr;
+			*reinterpret_cast<size_t*>(pb) = zmap;
+			*reinterpret_cast<memheap_**>(pb + EC_ALLOCTOR_ALIGN) = mapmark_();
+			if (psize)
+				*psize = zmap - 2 * EC_ALLOCTOR_ALIGN;
+			return pb + 2 * EC_ALLOCTOR_ALIGN;
+		}
+#endif
+
+#if EC_ALLOCTOR_STATS
+		void initstats_()
+		{
+			for (auto& st : _stats) {
+				st.nalloc.store(0);
+				st.nfree.store(0);
+				st.ncopy.store(0);
+				st.curbytes.store(0);
+				st.peakbytes.store(0);
+			}
+			_sampleevery.store(0);
+			_samplecount.store(0);
+			memset(&_sites[0], 0, sizeof(_sites));
+		}
+#endif
+		void* mallocblk_(uint32_t i, size_t size, size_t* psize)
+		{
+#if EC_ALLOCTOR_TCACHE
+			t_tcache* ptc = mytcache_();
+			if (ptc && ptc->mags[i].nbatch) {
+				t_mag* pm = &ptc->mags[i];
+				if (!pm->num && !(pm->num = _alloctors[i]->malloc_batch(pm->blks, pm->nbatch)))
+					return nullptr;
+				if (psize)
+					*psize = _alloctors[i]->sizeblk();
+				return pm->blks[--pm->num];
+			}
+#endif
+			return _alloctors[i]->malloc_(size, psize);
+		}
 
 	public:
 		bool add_alloctor(size_t sizeblk, size_t numblk, bool balloc = true)
@@ -501,11 +1133,18 @@ namespace ec{
 				delete p;
 				return false;
 			}
+			p->setid(_size);
 			_alloctors[_size++] = p;
 			return true;
 		}
 	public:
 		allocator() :_size(0), _alloctors{ nullptr } {
+#if EC_ALLOCTOR_TCACHE
+			_tcs = nullptr;
+#endif
+#if EC_ALLOCTOR_STATS
+			initstats_();
+#endif
 		}
 
 		allocator(size_t sizetiny, size_t numtiny,
@@ -513,6 +1152,12 @@ namespace ec{
 			size_t sizemid = 0, size_t nummid = 0,
 			size_t sizelg = 0, size_t numlg = 0
 		) :_size(0), _alloctors{ nullptr } {
+#if EC_ALLOCTOR_TCACHE
+			_tcs = nullptr;
+#endif
+#if EC_ALLOCTOR_STATS
+			initstats_();
+#endif
 			if (sizetiny && numtiny)
 				add_alloctor(sizetiny, numtiny);
 			if (sizesml && numsml)
@@ -524,6 +1169,17 @@ namespace ec{
 		}
 
 		~allocator() {
+#if EC_ALLOCTOR_TCACHE
+			{ // detach the caches of all threads, blocks in the caches released with the heaps
+				safe_lock<spinlock> lck(&tclck_());
+				while (_tcs) {
+					t_tcache* ptc = _tcs;
+					for (auto i = 0u; i < _size; i++)
+						ptc->mags[i].num = 0;
+					unlinktc_(ptc);
+				}
+			}
+#endif
 			for (auto i = 0u; i < _size; i++) {
 				if (_alloctors[i]) {
 					delete _alloctors[i];
@@ -538,17 +1194,44 @@ namespace ec{
 			return 0u == _size ? 0 : _alloctors[_size - 1]->sizeblk();
 		}
 
+#if EC_ALLOCTOR_STATS // not inlined, the return address is the call site of the public entry
+		EC_ALLOCTOR_NOINLINE void* malloc_(size_t size, size_t* psize = nullptr)
+		{
+			return mallocat_(size, psize, EC_ALLOCTOR_RETADDR());
+		}
+
+		EC_ALLOCTOR_NOINLINE void* realloc_(void* ptr, size_t size, size_t* poutsize = nullptr)
+		{
+			return reallocat_(ptr, size, poutsize, EC_ALLOCTOR_RETADDR());
+		}
+#else
 		void* malloc_(size_t size, size_t* psize = nullptr)
+		{
+			return mallocat_(size, psize, nullptr);
+		}
+
+		void* realloc_(void* ptr, size_t size, size_t* poutsize = nullptr)
+		{
+			return reallocat_(ptr, size, poutsize, nullptr);
+		}
+#endif
+
+		/*!
+		\brief malloc with the call site
+		\param paddr return address of the public entry, sampled if EC_ALLOCTOR_STATS
+		*/
+		void* mallocat_(size_t size, size_t* psize, const void* paddr)
 		{
 			void* pret = nullptr;
 			if (size > maxblksize()) { // malloc from system
-				pret = ::malloc(size + EC_ALLOCTOR_ALIGN);
-				if (!pret)
-					return nullptr;
-				*reinterpret_cast<memheap_**>(pret) = nullptr;
-				if (psize)
-					*psize = size;
-				return reinterpret_cast<char*>(pret) + EC_ALLOCTOR_ALIGN;
+				pret = sysmalloc_(size, psize);
+#if EC_ALLOCTOR_STATS
+				if (pret)
+					stat_alloc_(EC_SIZE_BLK_ALLOCATOR, (int64_t)syssize_(pret), paddr);
+#else
+				(void)paddr;
+#endif
+				return pret;
 			}
 			uint32_t i = 0u;
 			if (_size > 16) { // 1/2 find
@@ -566,37 +1249,64 @@ namespace ec{
 			}
 			for (; i < _size; i++) {
 				if (_alloctors[i]->sizeblk() >= size) {
-					pret = _alloctors[i]->malloc_(size, psize);
+#if EC_ALLOCTOR_STATS
+					if (nullptr != (pret = mallocblk_(i, size, psize)))
+						stat_alloc_(i, (int64_t)_alloctors[i]->sizeblk(), paddr);
 					return pret;
+#else
+					return mallocblk_(i, size, psize);
+#endif
 				}
 			}
 			return pret;
 		}
 
-		void* realloc_(void* ptr, size_t size, size_t* poutsize = nullptr)
+		/*!
+		\brief realloc with the call site
+		\param paddr return address of the public entry, sampled if EC_ALLOCTOR_STATS
+		*/
+		void* reallocat_(void* ptr, size_t size, size_t* poutsize, const void* paddr)
 		{
 			if (!ptr) { // malloc
 				if (!size)
 					return nullptr;
-				return malloc_(size, poutsize);
+				return mallocat_(size, poutsize, paddr);
 			}
 			if (!size) { // free
 				free_(ptr);
 				return nullptr;
 			}
 			memheap_** pheap = (memheap_**)(reinterpret_cast<char*>(ptr) - EC_ALLOCTOR_ALIGN);
-			if (!*pheap) { // system malloc
-				void* pret = ::realloc(pheap, size + EC_ALLOCTOR_ALIGN);
-				if (poutsize)
-					*poutsize = size;
-				return reinterpret_cast<char*>(pret) + EC_ALLOCTOR_ALIGN;
+			if (issysblk_(*pheap)) { // system malloc
+#if EC_ALLOCTOR_STATS
+				int64_t zold = (int64_t)syssize_(ptr);
+				void* pret = sysrealloc_(ptr, size, poutsize);
+				if (pret && (pret != ptr || (int64_t)syssize_(pret) != zold)) {
+					stat_free_(EC_SIZE_BLK_ALLOCATOR, zold);
+					stat_alloc_(EC_SIZE_BLK_ALLOCATOR, (int64_t)syssize_(pret), paddr);
+				}
+				return pret;
+#else
+				return sysrealloc_(ptr, size, poutsize);
+#endif
 			}
 			size_t sizeorg = (*pheap)->sizeblk();
-			if (sizeorg >= size)
+			if (sizeorg >= size) {
+				if (poutsize)
+					*poutsize = sizeorg;
 				return ptr;
-			char* pnew = (char*)malloc_(size, poutsize);
+			}
+			size_t znew = sizeorg + sizeorg / 2; // jump geometrically across size classes, the caller get the capacity by poutsize
+			if (znew < size)
+				znew = size;
+			else if (znew > maxblksize() && size <= maxblksize())
+				znew = maxblksize();
+			char* pnew = (char*)mallocat_(znew, poutsize, paddr);
 			if (!pnew)
 				return nullptr;
+#if EC_ALLOCTOR_STATS
+			stat_(reinterpret_cast<blk_alloctor<spinlock>*>((*pheap)->getalloc())->getid())->ncopy.fetch_add(1, std::memory_order_relaxed);
+#endif
 			memcpy(pnew, ptr, sizeorg);
 			free_(ptr);
 			return pnew;
@@ -607,11 +1317,153 @@ namespace ec{
 			if (!p)
 				return;
 			memheap_** pheap = (memheap_**)(reinterpret_cast<char*>(p) - EC_ALLOCTOR_ALIGN);
-			if (!*pheap) { // system malloc
-				::free(pheap);
+			if (issysblk_(*pheap)) { // system malloc
+#if EC_ALLOCTOR_STATS
+				stat_free_(EC_SIZE_BLK_ALLOCATOR, (int64_t)syssize_(p));
+#endif
+				sysfree_(p);
+				return;
+			}
+			PA_ pa = reinterpret_cast<blk_alloctor<spinlock>*>((*pheap)->getalloc());
+#if EC_ALLOCTOR_STATS
+			stat_free_(pa->getid(), (int64_t)pa->sizeblk());
+#endif
+#if EC_ALLOCTOR_TCACHE
+			t_tcache* ptc = mytcache_(); // blocks malloced by other threads also cached here, they all belong to the shared heaps
+			if (ptc && pa->getid() < _size && _alloctors[pa->getid()] == pa && ptc->mags[pa->getid()].nbatch) {
+				t_mag* pm = &ptc->mags[pa->getid()];
+				if (pm->num == pm->nbatch * 2) { // full, return the older half
+					pa->free_batch(pm->blks, pm->nbatch);
+					memmove(pm->blks, pm->blks + pm->nbatch, pm->nbatch * sizeof(void*));
+					pm->num = pm->nbatch;
+				}
+				pm->blks[pm->num++] = p;
 				return;
 			}
-			reinterpret_cast<blk_alloctor<spinlock>*>((*pheap)->getalloc())->free_(*pheap, p);
+#endif
+			pa->free_(*pheap, p);
+		}
+
+		/*!
+		\brief return the blocks cached by the calling thread to the shared blk_alloctor, e.g. before the thread idle for a long time
+		*/
+		void flushtc()
+		{
+#if EC_ALLOCTOR_TCACHE
+			t_tcache* ptc = tcache_();
+			if (ptc->powner.load(std::memory_order_relaxed) == this)
+				flushtc_(ptc);
+#endif
+		}
+
+		/*!
+		\brief get statistics of all size classes and the system malloc (the last, sizeblk = 0)
+		\return number of allocstat_ filled
+		*/
+		size_t getstats(allocstat_* pstats, size_t maxnum)
+		{
+			size_t n = 0;
+			for (auto i = 0u; i <= _size && n < maxnum; i++, n++) {
+				allocstat_* po = &pstats[n];
+				memset(po, 0, sizeof(allocstat_));
+				if (i < _size) {
+					po->sizeblk = _alloctors[i]->sizeblk();
+					po->numheaps = _alloctors[i]->numheaps();
+					po->numfreeblks = _alloctors[i]->numfreeblks();
+				}
+#if EC_ALLOCTOR_STATS
+				t_stat* ps = stat_(i);
+				po->nalloc = ps->nalloc.load(std::memory_order_relaxed);
+				po->nfree = ps->nfree.load(std::memory_order_relaxed);
+				po->ncopy = ps->ncopy.load(std::memory_order_relaxed);
+				po->curbytes = ps->curbytes.load(std::memory_order_relaxed);
+				po->peakbytes = ps->peakbytes.load(std::memory_order_relaxed);
+#endif
+			}
+			return n;
+		}
+
+		/*!
+		\brief sample the call site every 'every' allocations, 0: stop. only for EC_ALLOCTOR_STATS
+		\param bclear clear the recorded call sites
+		*/
+		void setsample(uint32_t every, bool bclear = false)
+		{
+#if EC_ALLOCTOR_STATS
+			_sampleevery.store(every, std::memory_order_relaxed);
+			if (bclear) {
+				safe_lock<spinlock> lck(&_sitelck);
+				memset(&_sites[0], 0, sizeof(_sites));
+			}
+#else
+			(void)every;
+			(void)bclear;
+#endif
+		}
+
+		/*!
+		\brief get the sampled call sites, sorted by bytes descending
+		\return number of allocsite_ filled
+		*/
+		size_t getsamples(allocsite_* psites, size_t maxnum)
+		{
+			size_t n = 0;
+#if EC_ALLOCTOR_STATS
+			safe_lock<spinlock> lck(&_sitelck);
+			size_t k;
+			for (auto i = 0; i < EC_ALLOCTOR_SAMPLE_SITES && maxnum; i++) { // insertion sort, keep the top maxnum
+				if (!_sites[i].addr)
+					continue;
+				if (n < maxnum)
+					k = n++;
+				else if (psites[maxnum - 1].bytes >= _sites[i].bytes)
+					continue;
+				else
+					k = maxnum - 1;
+				while (k > 0 && psites[k - 1].bytes < _sites[i].bytes) {
+					psites[k] = psites[k - 1];
+					k--;
+				}
+				psites[k] = _sites[i];
+			}
+#else
+			(void)psites;
+			(void)maxnum;
+#endif
+			return n;
+		}
+
+		/*!
+		\brief output statistics as json, {"stats":[allocstat_...],"sites":[allocsite_...]}
+		\param maxsites max call sites output, 0: not output sites
+		*/
+		template<class _STR>
+		void stats_tojson(_STR& sout, size_t maxsites = 32)
+		{
+			allocstat_ stats[EC_SIZE_BLK_ALLOCATOR + 1];
+			size_t i, n = getstats(stats, sizeof(stats) / sizeof(allocstat_));
+			sout.append("{\"stats\":[");
+			for (i = 0; i < n; i++) {
+				if (i)
+					sout.push_back(',');
+				stats[i].tojson(sout);
+			}
+			sout.push_back(']');
+			if (maxsites) {
+				allocsite_* psites = (allocsite_*)::malloc(sizeof(allocsite_) * maxsites);
+				if (psites) {
+					n = getsamples(psites, maxsites);
+					sout.append(",\"sites\":[");
+					for (i = 0; i < n; i++) {
+						if (i)
+							sout.push_back(',');
+						psites[i].tojson(sout);
+					}
+					sout.push_back(']');
+					::free(psites);
+				}
+			}
+			sout.push_back('}');
 		}
 
 		void prtfree() // for debug
@@ -816,8 +1668,360 @@ namespace ec {
 			get_ec_allocator()->free_(pobj);
 		}
 	}
+
+	/*!
+	\brief bump allocator for objects scoped to one message or one session, release in bulk.
+	blocks are carved from chunks of ec::allocator, free_ only rolls back the last block and
+	realloc_ grows the last block in place. Not thread safe, one arena is used by one thread at a time.
+
+	ec::arena::scope set the thread current arena used by ec::arena_stralloctor (ec::astring, ec::abytes)
+	and ec::arena_allocator, blocks allocated in the scope are released when the scope exit.
+	Objects from the current arena must not live longer than the scope.
+	*/
+	class arena
+	{
+	public:
+		class scope;
+	private:
+		struct chunk_ {
+			chunk_* _pnext; // older chunk
+			size_t _size; // data size, not include head
+			size_t _pos; // used size
+		};
+		struct t_ctx {
+			scope* _ptop; // the innermost scope
+			chunk_* _porphan; // chunks of the arenas destroyed in scope, free when the outermost scope exit
+		};
+		static constexpr size_t zalign_ = EC_ALLOCTOR_ALIGN;
+		static constexpr size_t zhead_ = sizeof(size_t) > zalign_ ? sizeof(size_t) : zalign_; // block head, size of block
+		static constexpr size_t zchunkhead_ = (sizeof(chunk_) + zalign_ - 1) / zalign_ * zalign_;
+
+		chunk_* _phead; // current chunk, the newest
+		void* _plast; // the last block in _phead
+		size_t _chunksize;
+	public:
+		class scope
+		{
+			friend class arena;
+			arena* _pa; // nullptr: the arena is destroyed in scope
+			chunk_* _pmark;
+			size_t _posmark;
+			scope* _pprev;
+		public:
+			scope(const scope&) = delete;
+			scope& operator = (const scope&) = delete;
+			scope(arena* pa) : _pa(pa), _pmark(pa->_phead), _posmark(pa->_phead ? pa->_phead->_pos : 0)
+			{
+				pa->_plast = nullptr; // not grow or roll back the block before scope
+				t_ctx* pctx = ctx_();
+				_pprev = pctx->_ptop;
+				pctx->_ptop = this;
+			}
+			~scope()
+			{
+				t_ctx* pctx = ctx_();
+				pctx->_ptop = _pprev;
+				if (_pa)
+					_pa->rollback_(_pmark, _posmark);
+				if (!pctx->_ptop && pctx->_porphan) {
+					freechunks_(pctx->_porphan);
+					pctx->_porphan = nullptr;
+				}
+			}
+		};
+
+		arena(const arena&) = delete;
+		arena& operator = (const arena&) = delete;
+
+		arena(size_t chunksize = EC_ARENA_CHUNKSIZE) : _phead(nullptr), _plast(nullptr), _chunksize(chunksize)
+		{
+			if (_chunksize < zchunkhead_ + 256u)
+				_chunksize = zchunkhead_ + 256u;
+		}
+		arena(arena&& v) noexcept : _phead(v._phead), _plast(v._plast), _chunksize(v._chunksize)
+		{
+			v._phead = nullptr;
+			v._plast = nullptr;
+			for (scope* ps = ctx_()->_ptop; ps; ps = ps->_pprev) {
+				if (ps->_pa == &v)
+					ps->_pa = this;
+			}
+		}
+		~arena()
+		{
+			bool binscope = false;
+			for (scope* ps = ctx_()->_ptop; ps; ps = ps->_pprev) {
+				if (ps->_pa == this) {
+					ps->_pa = nullptr;
+					binscope = true;
+				}
+			}
+			if (!_phead)
+				return;
+			if (!binscope) {
+				freechunks_(_phead);
+				return;
+			}
+			t_ctx* pctx = ctx_(); // blocks may be still used in scope, free at scope exit
+			chunk_* pc = _phead;
+			while (pc->_pnext)
+				pc = pc->_pnext;
+			pc->_pnext = pctx->_porphan;
+			pctx->_porphan = _phead;
+		}
+
+		void* malloc_(size_t size, size_t* poutsize = nullptr)
+		{
+			size_t zr = size ? (size + zalign_ - 1) / zalign_ * zalign_ : zalign_;
+			if (!_phead || _phead->_pos + zhead_ + zr > _phead->_size) {
+				if (!newchunk_(zhead_ + zr))
+					return nullptr;
+			}
+			uint8_t* p = data_(_phead) + _phead->_pos + zhead_;
+			*(size_t*)(p - zhead_) = zr;
+			_phead->_pos += zhead_ + zr;
+			_plast = p;
+			if (poutsize)
+				*poutsize = zr;
+			return p;
+		}
+
+		void* realloc_(void* ptr, size_t size, size_t* poutsize = nullptr)
+		{
+			if (!ptr)
+				return size ? malloc_(size, poutsize) : nullptr;
+			if (!size) {
+				free_(ptr);
+				return nullptr;
+			}
+			size_t zold = blksize_(ptr), zr = (size + zalign_ - 1) / zalign_ * zalign_;
+			if (zr <= zold) {
+				if (poutsize)
+					*poutsize = zold;
+				return ptr;
+			}
+			if (ptr == _plast && _phead->_pos + zr - zold <= _phead->_size) { // grow the last block in place
+				_phead->_pos += zr - zold;
+				*(size_t*)((uint8_t*)ptr - zhead_) = zr;
+				if (poutsize)
+					*poutsize = zr;
+				return ptr;
+			}
+			void* pnew = malloc_(zr < zold + zold / 2u ? zold + zold / 2u : zr, poutsize);
+			if (pnew)
+				memcpy(pnew, ptr, zold);
+			return pnew;
+		}
+
+		void free_(void* ptr)
+		{
+			if (ptr && ptr == _plast) {
+				_phead->_pos -= zhead_ + blksize_(ptr);
+				_plast = nullptr;
+			}
+		}
+
+		bool owns(const void* ptr) const
+		{
+			return owns_(_phead, ptr);
+		}
+
+		void reset() // release all blocks
+		{
+			rollback_(nullptr, 0);
+		}
+
+		size_t chunks() const
+		{
+			size_t n = 0;
+			for (chunk_* pc = _phead; pc; pc = pc->_pnext)
+				++n;
+			return n;
+		}
+
+		static arena* current() // the thread current arena, nullptr: not in scope
+		{
+			t_ctx* pctx = ctx_();
+			return pctx->_ptop ? pctx->_ptop->_pa : nullptr;
+		}
+
+		static bool inscope(const void* ptr) // ptr is allocated from an arena of any scope in the stack, not only the innermost
+		{
+			t_ctx* pctx = ctx_();
+			if (!ptr || !pctx->_ptop)
+				return false;
+			return owner_(ptr) || owns_(pctx->_porphan, ptr);
+		}
+
+		static void* cur_realloc_(void* ptr, size_t size, size_t* poutsize) // ptr is nullptr or inscope(ptr)
+		{
+			arena* pa = ptr ? owner_(ptr) : current();
+			if (pa) // grow in the owner arena, an outer scope block must not move to the inner scope arena
+				return pa->realloc_(ptr, size, poutsize);
+			if (!ptr)
+				return get_ec_allocator()->realloc_(ptr, size, poutsize);
+			if (!size) // orphan block
+				return nullptr;
+			pa = current();
+			size_t zold = blksize_(ptr);
+			if (size <= zold) {
+				if (poutsize)
+					*poutsize = zold;
+				return ptr;
+			}
+			void* pnew = pa ? pa->malloc_(size, poutsize) : get_ec_allocator()->malloc_(size, poutsize);
+			if (pnew)
+				memcpy(pnew, ptr, zold);
+			return pnew;
+		}
+
+		static void cur_free_(void* ptr) // ptr is inscope(ptr)
+		{
+			arena* pa = owner_(ptr);
+			if (pa)
+				pa->free_(ptr);
+		}
+	private:
+		static t_ctx* ctx_()
+		{
+			static thread_local t_ctx ctx; // zero initialized
+			return &ctx;
+		}
+		static arena* owner_(const void* ptr) // the arena in the scope stack owns ptr, nullptr: not found
+		{
+			for (scope* ps = ctx_()->_ptop; ps; ps = ps->_pprev) {
+				if (ps->_pa && ps->_pa->owns(ptr))
+					return ps->_pa;
+			}
+			return nullptr;
+		}
+		static inline uint8_t* data_(chunk_* pc)
+		{
+			return reinterpret_cast<uint8_t*>(pc) + zchunkhead_;
+		}
+		static inline size_t blksize_(const void* ptr)
+		{
+			return *(const size_t*)((const uint8_t*)ptr - zhead_);
+		}
+		static bool owns_(chunk_* pc, const void* ptr)
+		{
+			for (; pc; pc = pc->_pnext) {
+				if ((const uint8_t*)ptr >= data_(pc) && (const uint8_t*)ptr < data_(pc) + pc->_size)
+					return true;
+			}
+			return false;
+		}
+		static void freechunks_(chunk_* pc)
+		{
+			chunk_* pn;
+			while (pc) {
+				pn = pc->_pnext;
+				get_ec_allocator()->free_(pc);
+				pc = pn;
+			}
+		}
+		bool newchunk_(size_t zneed)
+		{
+			size_t zc = zchunkhead_ + zneed > _chunksize ? zchunkhead_ + zneed : _chunksize;
+			chunk_* pc = (chunk_*)get_ec_allocator()->malloc_(zc, &zc);
+			if (!pc)
+				return false;
+			pc->_pnext = _phead;
+			pc->_size = zc - zchunkhead_;
+			pc->_pos = 0;
+			_phead = pc;
+			_plast = nullptr;
+			return true;
+		}
+		void rollback_(chunk_* pmark, size_t posmark) // free chunks newer than pmark, pmark is nullptr or in list
+		{
+			while (_phead && _phead != pmark) {
+				chunk_* pn = _phead->_pnext;
+				get_ec_allocator()->free_(_phead);
+				_phead = pn;
+			}
+			if (_phead)
+				_phead->_pos = posmark;
+			_plast = nullptr;
+		}
+	};
+
+	// allocator for std containers from the current arena, use ec::allocator out of arena scope
+	template <class _Ty>
+	class arena_allocator
+	{
+	public:
+		using value_type = _Ty;
+		using pointer = _Ty*;
+		using reference = _Ty&;
+		using const_pointer = const _Ty*;
+		using const_reference = const _Ty&;
+		using size_type = size_t;
+		using difference_type = ptrdiff_t;
+
+		arena_allocator() noexcept {
+		}
+
+		arena_allocator(const arena_allocator& alloc) noexcept {
+		}
+
+		template <class U>
+		arena_allocator(const arena_allocator<U>& alloc) noexcept {
+		}
+
+		template <class _Other>
+		struct  rebind {
+			using other = arena_allocator<_Other>;
+		};
+
+		pointer allocate(size_type n, const void* hint = 0) {
+			arena* pa = arena::current();
+			return (pointer)(pa ? pa->malloc_(sizeof(value_type) * n) : get_ec_allocator()->malloc_(sizeof(value_type) * n));
+		}
+
+		void deallocate(pointer p, size_type n) {
+			if (arena::inscope(p))
+				arena::cur_free_(p);
+			else
+				get_ec_allocator()->free_(p);
+		}
+
+		size_type max_size() const noexcept {
+			return size_t(-1) / sizeof(value_type);
+		};
+
+		template <class _Objty, class... _Types>
+		void construct(_Objty* _Ptr, _Types&&... _Args) {
+			new ((void*)_Ptr) _Objty(std::forward<_Types>(_Args)...);
+		}
+
+		template <class _Uty>
+		void destroy(_Uty* const _Ptr) {
+			_Ptr->~_Uty();
+		}
+	};
+
+	template <class _Ty, class _Other>
+	bool operator==(const arena_allocator<_Ty>&, const arena_allocator<_Other>&) noexcept {
+		return true;
+	}
+
+	template <class _Ty, class _Other>
+	bool operator!=(const arena_allocator<_Ty>&, const arena_allocator<_Other>&) noexcept {
+		return false;
+	}
 } // namespace ec
 
+#if EC_ALLOCTOR_STATS // sample the call sites of ec_malloc, ec_realloc and ec_calloc, not the wrappers
+EC_ALLOCTOR_NOINLINE inline void* ec_malloc(size_t size, size_t* psize = nullptr) {
+	return  get_ec_allocator()->mallocat_(size, psize, EC_ALLOCTOR_RETADDR());
+}
+
+EC_ALLOCTOR_NOINLINE inline void* ec_realloc(void* ptr, size_t size, size_t* psize = nullptr)
+{
+	return  get_ec_allocator()->reallocat_(ptr, size, psize, EC_ALLOCTOR_RETADDR());
+}
+#else
 inline void* ec_malloc(size_t size, size_t* psize = nullptr) {
 	return  get_ec_allocator()->malloc_(size, psize);
 }
@@ -826,6 +2030,7 @@ inline void* ec_realloc(void* ptr, size_t size, size_t* psize = nullptr)
 {
 	return  get_ec_allocator()->realloc_(ptr, size, psize);
 }
+#endif
 
 inline void ec_free(void* ptr)
 {
@@ -833,9 +2038,15 @@ inline void ec_free(void* ptr)
 		get_ec_allocator()->free_(ptr);
 }
 
+#if EC_ALLOCTOR_STATS
+EC_ALLOCTOR_NOINLINE inline void* ec_calloc(size_t num, size_t size)
+{
+	void* pr = get_ec_allocator()->mallocat_(num * size, nullptr, EC_ALLOCTOR_RETADDR());
+#else
 inline void* ec_calloc(size_t num, size_t size)
 {
 	void* pr = get_ec_allocator()->malloc_(num * size);
+#endif
 	if (pr)
 		memset(pr, 0, num * size);
 	return pr;
@@ -3,6 +3,7 @@
 \author	jiangyong
 \email  kipway@outlook.com
 \update
+  2026.10.17 add ec::io::readfd() for linux, pread from an opened file without reopen and lock
   2023.10.23 update ec::io::getdiskspace() for linux use statfs::f_bavail
   2023.9.27 add ec::io::rmdir(),update path length from 512 to 1024
 
@@ -36,6 +37,7 @@ You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2
 #include <sys/stat.h>
 #include <sys/statfs.h>
 #include <fcntl.h>
+#include <errno.h>
 #endif
 #include <string>
 #include "ec_string.h"
@@ -486,6 +488,23 @@ namespace ec
 			::close(nfd);
 			return zread > 0;
 		}
+
+		/*!
+		\brief read from an opened file at offset, append to pout directly, no file pointer moved
+		\return the number of bytes read, 0: end of file; -1: error
+		*/
+		template <class _Out = std::string> //append _Out
+		long long readfd(int nfd, _Out *pout, long long offset, size_t lsize)
+		{
+			size_t zpos = pout->size();
+			pout->resize(zpos + lsize);
+			ssize_t nr;
+			do {
+				nr = ::pread64(nfd, (char*)pout->data() + zpos, lsize, offset);
+			} while (nr < 0 && errno == EINTR);
+			pout->resize(zpos + (nr > 0 ? (size_t)nr : 0));
+			return nr;
+		}
 #endif
 	}// namespace io
 
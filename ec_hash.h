@@ -3,6 +3,8 @@
 \author	jiangyong
 \email  kipway@outlook.com
 \update 2020.9.6
+2026.10.17 add hash64, word-at-a-time 64-bit hash of wyhash class, and hash64_i fold ASCII case in bulk.
+  string hash use hash64, integer hash mix the high bits to the low bits
 
 hash class for hashmap
 
@@ -14,16 +16,161 @@ You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2
 */
 
 #pragma once
+#include <stdint.h>
+#include <string.h>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
 namespace ec
 {
+	namespace hash_ {
+		constexpr uint64_t s0 = 0xa0761d6478bd642full;
+		constexpr uint64_t s1 = 0xe7037ed1a0b428dbull;
+		constexpr uint64_t s2 = 0x8ebc6af09c88c6e3ull;
+		constexpr uint64_t s3 = 0x589965cc75374cc3ull;
+		constexpr uint64_t lo7 = 0x7f7f7f7f7f7f7f7full;
+		constexpr uint64_t hi1 = 0x8080808080808080ull;
+		constexpr uint64_t one = 0x0101010101010101ull;
+
+		inline void mul128(uint64_t* a, uint64_t* b) // a,b = low,high of a * b
+		{
+#if defined(__SIZEOF_INT128__)
+			__uint128_t r = *a;
+			r *= *b;
+			*a = (uint64_t)r;
+			*b = (uint64_t)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+			*a = _umul128(*a, *b, b);
+#else
+			uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+			uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32), c = t < rl;
+			uint64_t lo = t + (rm1 << 32);
+			c += lo < t;
+			*a = lo;
+			*b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+		}
+
+		inline uint64_t mix(uint64_t a, uint64_t b)
+		{
+			mul128(&a, &b);
+			return a ^ b;
+		}
+
+		inline uint64_t lower8(uint64_t v) // ASCII 'A'-'Z' to 'a'-'z' of 8 bytes
+		{
+			uint64_t h = v & lo7;
+			uint64_t upper = (h + (0x80 - 'A') * one) & ~(h + (0x80 - 'Z' - 1) * one) & ~v & hi1;
+			return v | (upper >> 2);
+		}
+
+		template<bool bfold>
+		inline uint64_t r8(const uint8_t* p)
+		{
+			uint64_t v;
+			memcpy(&v, p, 8);
+			return bfold ? lower8(v) : v;
+		}
+
+		template<bool bfold>
+		inline uint64_t r4(const uint8_t* p)
+		{
+			uint32_t v;
+			memcpy(&v, p, 4);
+			return bfold ? lower8(v) : v;
+		}
+
+		template<bool bfold>
+		inline uint64_t r3(const uint8_t* p, size_t k) // 1-3 bytes
+		{
+			uint64_t v = (((uint64_t)p[0]) << 16) | (((uint64_t)p[k >> 1]) << 8) | p[k - 1];
+			return bfold ? lower8(v) : v;
+		}
+
+		template<bool bfold>
+		uint64_t hash64(const void* key, size_t len, uint64_t seed)
+		{
+			const uint8_t* p = (const uint8_t*)key;
+			uint64_t a, b;
+			seed ^= s0;
+			if (len <= 16) {
+				if (len >= 4) { // overlapped reads, no branch for each length
+					a = (r4<bfold>(p) << 32) | r4<bfold>(p + ((len >> 3) << 2));
+					b = (r4<bfold>(p + len - 4) << 32) | r4<bfold>(p + len - 4 - ((len >> 3) << 2));
+				}
+				else if (len > 0) {
+					a = r3<bfold>(p, len);
+					b = 0;
+				}
+				else
+					a = b = 0;
+			}
+			else {
+				size_t i = len;
+				if (i > 48) { // three lanes
+					uint64_t see1 = seed, see2 = seed;
+					do {
+						seed = mix(r8<bfold>(p) ^ s1, r8<bfold>(p + 8) ^ seed);
+						see1 = mix(r8<bfold>(p + 16) ^ s2, r8<bfold>(p + 24) ^ see1);
+						see2 = mix(r8<bfold>(p + 32) ^ s3, r8<bfold>(p + 40) ^ see2);
+						p += 48;
+						i -= 48;
+					} while (i > 48);
+					seed ^= see1 ^ see2;
+				}
+				while (i > 16) {
+					seed = mix(r8<bfold>(p) ^ s1, r8<bfold>(p + 8) ^ seed);
+					i -= 16;
+					p += 16;
+				}
+				a = r8<bfold>(p + i - 16);
+				b = r8<bfold>(p + i - 8);
+			}
+			a ^= s1;
+			b ^= seed;
+			mul128(&a, &b);
+			return mix(a ^ s0 ^ len, b ^ s1);
+		}
+
+		template<bool bfold>
+		inline uint64_t hashstr(const char* s) // null-terminated, keys not longer than 8 bytes use one multiplication
+		{
+			size_t n = strlen(s);
+			const uint8_t* p = (const uint8_t*)s;
+			if (n > 8u)
+				return hash64<bfold>(p, n, 0);
+			uint64_t v = n >= 4u ? r4<bfold>(p) | (r4<bfold>(p + n - 4) << 32) : (n ? r3<bfold>(p, n) : 0);
+			return mix(v ^ s1, n ^ s0);
+		}
+	}
+
+	/*!
+	\brief 64-bit hash of bytes, 8 bytes at a time
+	*/
+	inline uint64_t hash64(const void* key, size_t len, uint64_t seed = 0)
+	{
+		return hash_::hash64<false>(key, len, seed);
+	}
+
+	/*!
+	\brief case-insensitive hash64, fold ASCII 'A'-'Z' in bulk, the same as hash64 of the lower case bytes
+	*/
+	inline uint64_t hash64_i(const void* key, size_t len, uint64_t seed = 0)
+	{
+		return hash_::hash64<true>(key, len, seed);
+	}
+
 	template<class _Kty> // hash class
 	struct hash
 	{
 		size_t operator()(_Kty key)
 		{
-			if (sizeof(size_t) == 8)
-				return static_cast<size_t>(static_cast<size_t>(key) * 11400714819323198485ULL);
-			return (((size_t)key) * 2654435769U);
+			if (sizeof(size_t) == 8) { // fibonacci hash, swap the well distributed high half to the low bits used by % hashsize
+				uint64_t h = static_cast<uint64_t>(key) * 11400714819323198485ULL;
+				return static_cast<size_t>((h >> 32) | (h << 32));
+			}
+			uint32_t h = static_cast<uint32_t>(key) * 2654435769U;
+			return (h >> 16) | (h << 16);
 		}
 	};
 
@@ -32,10 +179,7 @@ namespace ec
 	{
 		size_t  operator()(const char*  key)
 		{
-			register unsigned int uHash = 0;
-			while (char ch = *key++)
-				uHash = uHash * 31 + ch;
-			return uHash;
+			return (size_t)hash_::hashstr<false>(key);
 		}
 	};
 
@@ -44,20 +188,137 @@ namespace ec
 	{
 		size_t operator()(char*  key)
 		{
-			register unsigned int uHash = 0;
-			while (char ch = *key++)
-				uHash = uHash * 31 + ch;
-			return uHash;
+			return (size_t)hash_::hashstr<false>(key);
 		}
 	};
 
 	struct hash_istr {
 		size_t  operator()(const char*  key)
 		{
-			register unsigned int uHash = 0;
-			while (char ch = *key++)
-				uHash = uHash * 31 + tolower(ch);
-			return uHash;
+			return (size_t)hash_::hashstr<true>(key);
 		}
 	};
 }
+/*
+// tsthash.cpp
+// benchmark of the string hash and the bucket distribution of hash % 1024, old: hash before hash64
+// g++ -O2 -I../eclib3 -std=c++11 -otsthash tsthash.cpp
+// at Intel Xeon, debian 12 G++ 12.2, min-max of 5 runs
+// ns per key        old          new
+// headers        7.3-11.6      4.9-7.3
+// headers(i)    45.2-54.5      7.1-12.3
+// urls(92)      81.0-89.7      9.3-15.5
+// mime exts      2.6-3.5       3.8-4.8
+// largest bucket of 1024, 100k keys(ideal 98)   old    new
+// sequential fds             98     99
+// fds stride 1024        100000    100
+// "sess<N>" strings         224    128
+
+#include "ec_system.h"
+#include "ec_hash.h"
+#include "ec_time.h"
+
+#include <ctype.h>
+#include <vector>
+#include <string>
+
+struct old_str { // hash before hash64
+	size_t operator()(const char* key) {
+		unsigned int u = 0;
+		while (char ch = *key++)
+			u = u * 31 + ch;
+		return u;
+	}
+};
+struct old_istr {
+	size_t operator()(const char* key) {
+		unsigned int u = 0;
+		while (char ch = *key++)
+			u = u * 31 + tolower(ch);
+		return u;
+	}
+};
+struct old_int {
+	size_t operator()(int key) {
+		return static_cast<size_t>(static_cast<size_t>(key) * 11400714819323198485ULL);
+	}
+};
+
+template<class _Hasher>
+double nskey(const std::vector<const char*>& keys) // ns per key, best of 7
+{
+	double best = 1e9;
+	for (int t = 0; t < 7; t++) {
+		size_t sum = 0;
+		int64_t t1 = ec::time_ns();
+		for (int r = 0; r < 100000; r++) {
+			for (auto& k : keys)
+				sum += _Hasher()(k);
+		}
+		int64_t t2 = ec::time_ns();
+		if (sum == 7)
+			printf("-");
+		double ns = (double)(t2 - t1) * 1000.0 / (100000.0 * keys.size()); // time_ns() is in microseconds
+		if (ns < best)
+			best = ns;
+	}
+	return best;
+}
+
+template<class _Hasher, class _Key>
+size_t maxbucket(const std::vector<_Key>& keys, size_t buckets = 1024) // the largest bucket of "hash % buckets"
+{
+	std::vector<size_t> v(buckets, 0);
+	size_t nmax = 0;
+	for (auto& k : keys) {
+		size_t n = ++v[_Hasher()(k) % buckets];
+		if (n > nmax)
+			nmax = n;
+	}
+	return nmax;
+}
+
+int main()
+{
+	const char* hdrs[] = { "Host", "User-Agent", "Accept", "Accept-Language", "Accept-Encoding", "Connection",
+		"Upgrade-Insecure-Requests", "Sec-WebSocket-Key", "Sec-WebSocket-Version", "Sec-WebSocket-Extensions",
+		"Sec-WebSocket-Protocol", "Content-Type", "Content-Length", "Cookie", "Range", "If-None-Match",
+		"If-Modified-Since", "Cache-Control", "Pragma", "Referer", "Origin", "Transfer-Encoding", "Authorization",
+		"X-Forwarded-For" };
+	const char* exts[] = { "html", "htm", "css", "js", "json", "png", "jpg", "jpeg", "gif", "svg", "ico", "txt", "xml",
+		"pdf", "zip", "gz", "mp4", "webm", "woff", "woff2", "ttf", "wasm", "mp3", "wav", "csv", "map" };
+	std::vector<const char*> vh(hdrs, hdrs + sizeof(hdrs) / sizeof(const char*));
+	std::vector<const char*> ve(exts, exts + sizeof(exts) / sizeof(const char*));
+	std::vector<std::string> surls;
+	std::vector<const char*> vu;
+	for (int i = 0; i < 16; i++) {
+		char s[128];
+		snprintf(s, sizeof(s), "/api/v1/devices/%08d/telemetry/history?from=2026-10-01T00:00:00Z&to=2026-10-17&page=%04d", i * 7919, i);
+		surls.push_back(s);
+	}
+	for (auto& s : surls)
+		vu.push_back(s.c_str());
+
+	printf("ns per key     old    new\n");
+	printf("headers     %6.1f %6.1f\n", nskey<old_str>(vh), nskey<ec::hash<const char*>>(vh));
+	printf("headers(i)  %6.1f %6.1f\n", nskey<old_istr>(vh), nskey<ec::hash_istr>(vh));
+	printf("urls(%zu)    %6.1f %6.1f\n", surls[0].size(), nskey<old_str>(vu), nskey<ec::hash<const char*>>(vu));
+	printf("mime exts   %6.1f %6.1f\n", nskey<old_str>(ve), nskey<ec::hash<const char*>>(ve));
+
+	std::vector<int> vseq, vstride;
+	std::vector<std::string> ssess;
+	std::vector<const char*> vsess;
+	for (int i = 0; i < 100000; i++) {
+		vseq.push_back(i);
+		vstride.push_back(i * 1024);
+		ssess.push_back("sess" + std::to_string(i));
+	}
+	for (auto& s : ssess)
+		vsess.push_back(s.c_str());
+	printf("largest bucket of 1024, 100k keys(ideal 98)   old    new\n");
+	printf("sequential fds         %6zu %6zu\n", maxbucket<old_int>(vseq), maxbucket<ec::hash<int>>(vseq));
+	printf("fds stride 1024        %6zu %6zu\n", maxbucket<old_int>(vstride), maxbucket<ec::hash<int>>(vstride));
+	printf("\"sess<N>\" strings      %6zu %6zu\n", maxbucket<old_str>(vsess), maxbucket<ec::hash<const char*>>(vsess));
+	return 0;
+}
+*/
@@ -3,12 +3,18 @@
 \author jiangyong
 \email  kipway@outlook.com
 \update 2023.5.13
+2026.10.17 flatmap first table use the capacity sized by initsize, not doubled
+2026.10.17 add flatmap, open addressing hash map with SSE2 group probe and incremental rehash
 2023.5.13 use _USE_EC_OBJ_ALLOCATOR
 
 hashmap
 	A hash map class, incompatible with std::unordered_map.
 	iterator:	a forward iterator to value_type(not pair for key-val).
 
+flatmap
+	An open addressing hash map with the same interface as hashmap, values stored in the table.
+	iterator:	invalid after any modify of the map, see class flatmap.
+
 eclib 3.0 Copyright (c) 2017-2022, kipway
 source repository : https://github.com/kipway
 
@@ -19,9 +25,31 @@ You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2
 #pragma once
 #include <functional>
 #include <memory.h>
+#include <stdint.h>
+#include <new>
+#include <type_traits>
 #include "ec_alloctor.h"
 #include "ec_hash.h"
 
+#ifndef EC_FLATMAP_SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EC_FLATMAP_SSE2 1
+#else
+#define EC_FLATMAP_SSE2 0
+#endif
+#endif
+
+#if EC_FLATMAP_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifndef EC_FLATMAP_REHASH_STEP // flatmap slots of old table moved in each set/emplace/erase while rehash
+#define EC_FLATMAP_REHASH_STEP 64
+#endif
+
 namespace ec
 {
 	template<class _Kty, class _Ty> // is _Kty is equal to the key in class _Ty
@@ -482,6 +510,498 @@ namespace ec
 			return -1;
 		}
 	};
+
+	/*!
+	\brief open addressing hash map, SwissTable style control bytes in groups of 16, a group probed by SSE2.
+	The same template parameters and interface as hashmap. Values are stored in the table, the pointer of a value
+	is invalid after set/emplace/erase. Grow by incremental rehash, each set/emplace/erase moves some slots of
+	the old table to the new table, no long pause when the map is big.
+	Any set/emplace/erase/clear invalidates all iterators, references and pointers to values, also when called by
+	a callback in a range-for loop. Do not modify the map while iterating, collect the keys first and then modify.
+	*/
+	template<class _Kty
+		, class _Ty
+		, class _Keyeq = keq_mapnode<_Kty, _Ty>
+		, class _DelVal = del_mapnode<_Ty>
+		, class _Hasher = hash<_Kty>>
+		class flatmap
+	{
+	public:
+		using value_type = _Ty;
+		using reference = value_type & ;
+		using const_reference = const value_type &;
+		using key_type = _Kty;
+		using size_type = size_t;
+
+		class iterator
+		{
+		public:
+			iterator(flatmap* pmap, uint64_t pos) :_pmap(pmap), _pos(pos)
+			{
+			}
+
+			bool operator == (const iterator& v)
+			{
+				return _pos == v._pos;
+			}
+
+			bool operator != (const iterator& v)
+			{
+				return _pos != v._pos;
+			}
+
+			iterator& operator ++() // ++i
+			{
+				_pos = _pmap->_nexti(_pos + 1);
+				return *this;
+			}
+
+			iterator operator ++(int) // i++
+			{
+				iterator i(_pmap, _pos);
+				_pos = _pmap->_nexti(_pos + 1);
+				return i;
+			}
+
+			reference operator*()
+			{
+				return *_pmap->atpos(_pos);
+			}
+		private:
+			flatmap* _pmap;
+			uint64_t _pos;
+		};
+	private:
+		static constexpr size_t zgroup_ = 16; // slots of one group
+		static constexpr uint8_t ctrl_empty = 0x80;
+		static constexpr uint8_t ctrl_deleted = 0xFE; // full: 0-127, the low 7 bits of hash
+
+		struct t_slot {
+			size_t hash; // rehash without key
+			typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type val;
+		};
+		struct t_table {
+			uint8_t* ctrl; // cap bytes
+			t_slot* slots;
+			size_t cap; // 0 or power of 2, >= zgroup_
+			size_t size;
+			size_t growth; // empty slots can be used before rehash, max load factor 7/8
+		};
+
+		t_table _tab;
+		t_table _old; // table in rehash, slots before _migpos are moved to _tab
+		size_t _migpos;
+		size_t _initcap;
+	public:
+		flatmap(const flatmap&) = delete;
+		flatmap& operator = (const flatmap&) = delete;
+
+		flatmap(unsigned int initsize = 16) : _migpos(0)
+		{
+			memset(&_tab, 0, sizeof(_tab));
+			memset(&_old, 0, sizeof(_old));
+			_initcap = zgroup_;
+			while (_initcap - _initcap / 8 < initsize)
+				_initcap *= 2;
+		}
+
+		~flatmap()
+		{
+			clear();
+			freetable_(_tab);
+		}
+
+		flatmap& operator = (flatmap&& v) // for move
+		{
+			this->~flatmap();
+			_tab = v._tab;
+			_old = v._old;
+			_migpos = v._migpos;
+			_initcap = v._initcap;
+			memset(&v._tab, 0, sizeof(v._tab));
+			memset(&v._old, 0, sizeof(v._old));
+			v._migpos = 0;
+			return *this;
+		}
+
+		inline static size_t size_node()
+		{
+			return sizeof(t_slot) + 1;
+		}
+
+		inline size_type size() const noexcept
+		{
+			return _tab.size + _old.size;
+		}
+
+		inline bool empty() const noexcept
+		{
+			return !size();
+		}
+
+		inline size_type capacity() const noexcept
+		{
+			return _tab.cap;
+		}
+
+		iterator begin()
+		{
+			return iterator(this, _nexti(0));
+		}
+
+		iterator end()
+		{
+			return iterator(this, -1);
+		}
+
+		bool set(key_type key, value_type& Value) noexcept
+		{
+			size_t h = hash_(key);
+			migrate_(EC_FLATMAP_REHASH_STEP);
+			value_type* pv = find_(key, h);
+			if (pv) {
+				_DelVal()(*pv);
+				*pv = Value;
+				return true;
+			}
+			size_t i = newslot_(h);
+			if (i == SIZE_MAX)
+				return false;
+			new (&_tab.slots[i].val) value_type(Value);
+			return true;
+		}
+
+		bool set(key_type key, value_type&& Value) noexcept
+		{
+			size_t h = hash_(key);
+			migrate_(EC_FLATMAP_REHASH_STEP);
+			value_type* pv = find_(key, h);
+			if (pv) {
+				_DelVal()(*pv);
+				*pv = std::move(Value);
+				return true;
+			}
+			size_t i = newslot_(h);
+			if (i == SIZE_MAX)
+				return false;
+			new (&_tab.slots[i].val) value_type(std::move(Value));
+			return true;
+		}
+
+		value_type* get(key_type key) noexcept
+		{
+			if (!size())
+				return nullptr;
+			return find_(key, hash_(key));
+		}
+
+		bool get(key_type key, value_type& Value) noexcept
+		{
+			value_type* pv = get(key);
+			if (nullptr == pv)
+				return false;
+			Value = *pv;
+			return true;
+		}
+
+		inline bool has(key_type key) noexcept
+		{
+			return nullptr != get(key);
+		}
+
+		void clear() noexcept
+		{
+			cleartable_(_old);
+			freetable_(_old);
+			_migpos = 0;
+			cleartable_(_tab);
+		}
+
+		bool erase(key_type key) noexcept
+		{
+			return erase(key, [](value_type& val) {
+				_DelVal()(val);
+			});
+		}
+
+		bool erase(key_type key, std::function<void(value_type& val)>ondel) noexcept
+		{
+			if (!size())
+				return false;
+			size_t h = hash_(key);
+			migrate_(EC_FLATMAP_REHASH_STEP);
+			t_table* pt = &_tab;
+			size_t i = findslot_(_tab, key, h);
+			if (i == SIZE_MAX && _old.cap) {
+				pt = &_old;
+				i = findslot_(_old, key, h);
+			}
+			if (i == SIZE_MAX)
+				return false;
+			value_type v(std::move(*valptr_(*pt, i))); // remove from the table first, ondel may use the map
+			valptr_(*pt, i)->~value_type();
+			delslot_(*pt, i);
+			ondel(v);
+			return true;
+		}
+
+		value_type* next(uint64_t& i) noexcept
+		{
+			uint64_t pos = _nexti(i);
+			if (pos == (uint64_t)-1) {
+				i = -1;
+				return nullptr;
+			}
+			i = pos + 1;
+			return atpos(pos);
+		}
+
+		bool next(uint64_t& i, value_type*& pv) noexcept
+		{
+			pv = next(i);
+			return pv != nullptr;
+		}
+
+		bool next(uint64_t& i, value_type& rValue) noexcept
+		{
+			value_type* pv = nullptr;
+			bool bret = next(i, pv);
+			if (bret)
+				rValue = *pv;
+			return bret;
+		}
+
+		template <typename... Args>
+		bool emplace(key_type key, Args&&... args) noexcept
+		{
+			erase(key);
+			size_t i = newslot_(hash_(key));
+			if (i == SIZE_MAX)
+				return false;
+			new (&_tab.slots[i].val) value_type(std::forward<Args>(args)...);
+			return true;
+		}
+	protected:
+		uint64_t _nexti(uint64_t pos) noexcept // the first value at or after pos, old table first, -1: end
+		{
+			if (pos < _old.cap) {
+				for (size_t i = (size_t)pos < _migpos ? _migpos : (size_t)pos; i < _old.cap; i++) {
+					if (!(_old.ctrl[i] & 0x80))
+						return i;
+				}
+				pos = _old.cap;
+			}
+			for (size_t i = (size_t)(pos - _old.cap); i < _tab.cap; i++) {
+				if (!(_tab.ctrl[i] & 0x80))
+					return i + _old.cap;
+			}
+			return -1;
+		}
+
+		value_type* atpos(uint64_t pos) noexcept
+		{
+			if (pos < _old.cap)
+				return valptr_(_old, (size_t)pos);
+			return valptr_(_tab, (size_t)(pos - _old.cap));
+		}
+	private:
+		static size_t hash_(key_type key)
+		{
+			uint64_t h = (uint64_t)_Hasher()(key); // mix, the low 7 bits in control byte and the high bits select group
+			h ^= h >> 32;
+			h *= 0x9E3779B97F4A7C15ULL;
+			h ^= h >> 29;
+			return (size_t)h;
+		}
+
+		static inline int ctz_(uint32_t v)
+		{
+#ifdef _MSC_VER
+			unsigned long r;
+			_BitScanForward(&r, v);
+			return (int)r;
+#else
+			return __builtin_ctz(v);
+#endif
+		}
+
+		static inline uint32_t match_(const uint8_t* pg, uint8_t c) // bit mask of the control bytes equal to c in group
+		{
+#if EC_FLATMAP_SSE2
+			return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8((char)c),
+				_mm_loadu_si128((const __m128i*)pg)));
+#else
+			uint32_t m = 0;
+			for (auto i = 0u; i < zgroup_; i++) {
+				if (pg[i] == c)
+					m |= 1u << i;
+			}
+			return m;
+#endif
+		}
+
+		static inline uint32_t matchfree_(const uint8_t* pg) // empty or deleted
+		{
+#if EC_FLATMAP_SSE2
+			return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)pg));
+#else
+			uint32_t m = 0;
+			for (auto i = 0u; i < zgroup_; i++) {
+				if (pg[i] & 0x80)
+					m |= 1u << i;
+			}
+			return m;
+#endif
+		}
+
+		static inline value_type* valptr_(t_table& t, size_t i)
+		{
+			return reinterpret_cast<value_type*>(&t.slots[i].val);
+		}
+
+		static size_t findslot_(t_table& t, key_type key, size_t h)
+		{
+			if (!t.cap)
+				return SIZE_MAX;
+			size_t mask = t.cap / zgroup_ - 1, g = (h >> 7) & mask, ipos;
+			uint8_t h2 = (uint8_t)(h & 0x7F);
+			uint32_t m;
+			for (size_t n = 1; ; n++) { // triangular probe visit all groups
+				const uint8_t* pg = t.ctrl + g * zgroup_;
+				m = match_(pg, h2);
+				while (m) {
+					ipos = g * zgroup_ + ctz_(m);
+					if (t.slots[ipos].hash == h && _Keyeq()(key, *valptr_(t, ipos)))
+						return ipos;
+					m &= m - 1;
+				}
+				if (match_(pg, ctrl_empty) || n > mask)
+					return SIZE_MAX;
+				g = (g + n) & mask;
+			}
+		}
+
+		value_type* find_(key_type key, size_t h)
+		{
+			size_t i = findslot_(_tab, key, h);
+			if (i != SIZE_MAX)
+				return valptr_(_tab, i);
+			if (_old.cap && SIZE_MAX != (i = findslot_(_old, key, h)))
+				return valptr_(_old, i);
+			return nullptr;
+		}
+
+		static size_t freeslot_(t_table& t, size_t h) // the first empty or deleted slot on probe sequence
+		{
+			size_t mask = t.cap / zgroup_ - 1, g = (h >> 7) & mask;
+			uint32_t m;
+			for (size_t n = 1; ; n++) {
+				m = matchfree_(t.ctrl + g * zgroup_);
+				if (m)
+					return g * zgroup_ + ctz_(m);
+				g = (g + n) & mask;
+			}
+		}
+
+		static void setslot_(t_table& t, size_t i, size_t h)
+		{
+			if (t.ctrl[i] == ctrl_empty)
+				t.growth--;
+			t.ctrl[i] = (uint8_t)(h & 0x7F);
+			t.slots[i].hash = h;
+			t.size++;
+		}
+
+		static void delslot_(t_table& t, size_t i)
+		{
+			if (match_(t.ctrl + i / zgroup_ * zgroup_, ctrl_empty)) {
+				t.ctrl[i] = ctrl_empty; // no probe sequence passed through a group with empty slot
+				t.growth++;
+			}
+			else
+				t.ctrl[i] = ctrl_deleted;
+			t.size--;
+		}
+
+		static bool newtable_(t_table& t, size_t cap)
+		{
+			void* p = ec_malloc(cap + cap * sizeof(t_slot));
+			if (!p)
+				return false;
+			t.ctrl = (uint8_t*)p;
+			t.slots = (t_slot*)((uint8_t*)p + cap);
+			t.cap = cap;
+			t.size = 0;
+			t.growth = cap - cap / 8;
+			memset(t.ctrl, ctrl_empty, cap);
+			return true;
+		}
+
+		static void freetable_(t_table& t)
+		{
+			if (t.ctrl)
+				ec_free(t.ctrl);
+			memset(&t, 0, sizeof(t));
+		}
+
+		void cleartable_(t_table& t)
+		{
+			if (!t.size)
+				return;
+			for (size_t i = 0; i < t.cap; i++) {
+				if (!(t.ctrl[i] & 0x80)) {
+					_DelVal()(*valptr_(t, i));
+					valptr_(t, i)->~value_type();
+				}
+			}
+			memset(t.ctrl, ctrl_empty, t.cap);
+			t.size = 0;
+			t.growth = t.cap - t.cap / 8;
+		}
+
+		void migrate_(size_t nslots) // move slots from _old to _tab
+		{
+			if (!_old.cap)
+				return;
+			size_t iend = nslots > _old.cap - _migpos ? _old.cap : _migpos + nslots, i;
+			for (; _migpos < iend; _migpos++) {
+				if (_old.ctrl[_migpos] & 0x80)
+					continue;
+				t_slot& s = _old.slots[_migpos];
+				i = freeslot_(_tab, s.hash);
+				new (&_tab.slots[i].val) value_type(std::move(*valptr_(_old, _migpos)));
+				valptr_(_old, _migpos)->~value_type();
+				setslot_(_tab, i, s.hash);
+				_old.ctrl[_migpos] = ctrl_deleted;
+				_old.size--;
+			}
+			if (_migpos >= _old.cap) {
+				freetable_(_old);
+				_migpos = 0;
+			}
+		}
+
+		size_t newslot_(size_t h) // the key is not in the map
+		{
+			if (!_tab.growth) {
+				migrate_(SIZE_MAX); // finish the last rehash
+				size_t cap = _tab.cap ? _tab.cap : _initcap;
+				if (_tab.cap && _tab.size >= (_tab.cap - _tab.cap / 8) / 2) // else only clean up deleted
+					cap *= 2;
+				t_table t;
+				if (!newtable_(t, cap))
+					return SIZE_MAX;
+				_old = _tab;
+				_tab = t;
+				_migpos = 0;
+				if (_old.cap <= EC_FLATMAP_REHASH_STEP * 4) // small table move at once
+					migrate_(SIZE_MAX);
+			}
+			size_t i = freeslot_(_tab, h);
+			setslot_(_tab, i, h);
+			return i;
+		}
+	};
 }
 
 /*
@@ -3,6 +3,13 @@
 \author	jiangyong
 \email  kipway@outlook.com
 \update 
+  2026-10-17 parsebuffer ring remap failed fall back to a heap buffer, setring(0) leave ring mode at once
+  2026-10-17 parsebuffer::setring map the ring buffer at once and return the actual mode, add isring()
+  2026-10-17 add parsebuffer ring mode, double mapped memfd buffer, no compaction move and no copy when grow in the capacity
+  2026-10-17 parsebuffer grow by realloc_, big buffer grow by mremap without copy
+  2026-10-17 add io_buffer::peekiov, export head blocks as iovec for writev/sendmsg; add io_buffer::allocator
+  2026-10-17 add parsebuffer::reserve and commit, recv directly into parsebuffer
+  2026-10-17 add io_buffer::peek, get head blocks without free
   2023-5-21 update io_buffer
   2023-5-13 autobuf remove ec::memory
   2023-5-8 add ec::memory::maxblksize()
@@ -19,7 +26,7 @@ io_buffer
 	for net io send
 
 parsebuffer
-	for net io read parse buffer
+	for net io read parse buffer, setring() use a double mapped ring buffer in linux
 
 eclib 3.0 Copyright (c) 2017-2023, kipway
 source repository : https://github.com/kipway
@@ -33,9 +40,31 @@ You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2
 #include <cstdint>
 #include <memory.h>
 #include <vector>
+#ifndef _WIN32
+#include <limits.h>
+#include <sys/uio.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#endif
 #include "ec_mutex.h"
 #include "ec_alloctor.h"
 
+#ifndef EC_PARSEBUF_RING_KEEPSIZE // ring buffer not bigger than this keep mapped when it is empty
+#if defined(_MEM_TINY) // < 256M
+#define EC_PARSEBUF_RING_KEEPSIZE (1024 * 1024)
+#elif defined(_MEM_SML) // < 1G
+#define EC_PARSEBUF_RING_KEEPSIZE (1024 * 1024 * 4)
+#else
+#define EC_PARSEBUF_RING_KEEPSIZE (1024 * 1024 * 8)
+#endif
+#endif
+
 namespace ec {
 	template <typename _Tp = char>
 	class autobuf
@@ -221,6 +250,9 @@ namespace ec {
 		inline size_t sizemax() {
 			return _sizemax;
 		}
+		inline BLK_ALLOCTOR* allocator() {
+			return _pallocator;
+		}
 		int waterlevel() //水位,百分数.
 		{
 			size_t numblk = _size * 10000;
@@ -292,6 +324,57 @@ namespace ec {
 			return pret;
 		}
 
+		/**
+		 * @brief get data blocks from head without free, for gathered or linked send
+		 * @param pbufs out data pointers
+		 * @param plens out data lengths
+		 * @param maxblks size of pbufs and plens
+		 * @return number of blocks
+		 * @remark the blocks are valid until freesize(), call freesize() after send.
+		*/
+		int peek(const void** pbufs, size_t* plens, int maxblks)
+		{
+			int n = 0;
+			blk_* p = _phead;
+			while (p && n < maxblks) {
+				if (p->len > p->pos) {
+					pbufs[n] = pdata_(p) + p->pos;
+					plens[n] = p->len - p->pos;
+					++n;
+				}
+				p = p->pnext;
+			}
+			return n;
+		}
+
+#ifndef _WIN32
+		/**
+		 * @brief export the head blocks as iovec for writev/sendmsg, no copy and not free
+		 * @param iovs out iovec array
+		 * @param maxiov size of iovs, limit to IOV_MAX
+		 * @return number of iovec
+		 * @remark call freesize() with the bytes sent, a partial write frees the sent blocks and moves pos of the next block.
+		*/
+		int peekiov(struct iovec* iovs, int maxiov)
+		{
+#ifdef IOV_MAX
+			if (maxiov > IOV_MAX)
+				maxiov = IOV_MAX;
+#endif
+			int n = 0;
+			blk_* p = _phead;
+			while (p && n < maxiov) {
+				if (p->len > p->pos) {
+					iovs[n].iov_base = pdata_(p) + p->pos;
+					iovs[n].iov_len = p->len - p->pos;
+					++n;
+				}
+				p = p->pnext;
+			}
+			return n;
+		}
+#endif
+
 		//从头部开始释放zlen长度数据,当调用get后使用。
 		void freesize(size_t zlen)
 		{
@@ -319,7 +402,7 @@ namespace ec {
 	class parsebuffer //协议解析优化缓冲,去掉解析时移动拷贝
 	{
 	public:
-		parsebuffer() : _head(0), _tail(0), _bufsize(0), _pos(0), _pbuf(nullptr) {
+		parsebuffer() : _head(0), _tail(0), _bufsize(0), _pos(0), _pbuf(nullptr), _ringsize(0), _bmap(false) {
 		}
 		~parsebuffer() {
 			free();
@@ -332,12 +415,15 @@ namespace ec {
 			_bufsize = v._bufsize;
 			_pos = v._pos;
 			_pbuf = v._pbuf;
+			_ringsize = v._ringsize;
+			_bmap = v._bmap;
 
 			v._head = 0;
 			v._tail = 0;
 			v._bufsize = 0;
 			v._pos = 0;
 			v._pbuf = nullptr;
+			v._bmap = false;
 		}
 
 		parsebuffer& operator = (parsebuffer&& v) noexcept // for move
@@ -349,12 +435,15 @@ namespace ec {
 			_bufsize = v._bufsize;
 			_pbuf = v._pbuf;
 			_pos = v._pos;
+			_ringsize = v._ringsize;
+			_bmap = v._bmap;
 
 			v._head = 0;
 			v._tail = 0;
 			v._bufsize = 0;
 			v._pos = 0;
 			v._pbuf = nullptr;
+			v._bmap = false;
 
 			return *this;
 		}
@@ -365,6 +454,8 @@ namespace ec {
 		size_t _bufsize;
 		size_t _pos;  // read write as stream, position from _head
 		uint8_t* _pbuf;
+		size_t _ringsize; // >0: ring mode, the min capacity of ring buffer
+		bool _bmap; // _pbuf is a double mapped ring buffer, _head < _bufsize and _tail <= _head + _bufsize
 	private:
 		void* malloc_(size_t size, size_t& outsize) {
 			return ::get_ec_allocator()->malloc_(size, &outsize);
@@ -372,6 +463,112 @@ namespace ec {
 		void free_(void* p) {
 			return ::get_ec_allocator()->free_(p);
 		}
+		/**
+		 * @brief map a ring buffer, the second half is the mirror of the first half, data from _head is always continuous
+		 * @param size capacity, rounded up to page size
+		 * @param poutsize [out] capacity
+		 * @return the buffer with size 2 * (*poutsize) virtual space; nullptr: failed or not support
+		*/
+		static uint8_t* mapring_(size_t size, size_t* poutsize)
+		{
+#if defined(__linux__) && defined(SYS_memfd_create)
+			static const size_t zpage = (size_t)sysconf(_SC_PAGESIZE);
+			size = (size + zpage - 1) / zpage * zpage;
+			int fd = (int)syscall(SYS_memfd_create, "ec_parsebuffer", MFD_CLOEXEC);
+			if (fd < 0)
+				return nullptr;
+			if (ftruncate(fd, (off_t)size) < 0) {
+				::close(fd);
+				return nullptr;
+			}
+			uint8_t* p = (uint8_t*)mmap(nullptr, size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (p == (uint8_t*)MAP_FAILED) {
+				::close(fd);
+				return nullptr;
+			}
+			if (mmap(p, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED
+				|| mmap(p + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+				munmap(p, size * 2);
+				::close(fd);
+				return nullptr;
+			}
+			::close(fd); // the mappings keep the memory
+			*poutsize = size;
+			return p;
+#else
+			return nullptr;
+#endif
+		}
+
+		static void unmapring_(uint8_t* p, size_t size)
+		{
+#ifdef __linux__
+			munmap(p, size * 2);
+#endif
+		}
+
+		bool remap_(size_t size) // move data to a new ring buffer with capacity size at least
+		{
+			size_t oldsize = _tail - _head, newbufsize = 0;
+			uint8_t* pnew = mapring_(size > _ringsize ? size : _ringsize, &newbufsize);
+			if (!pnew)
+				return false;
+			if (oldsize)
+				memcpy(pnew, _pbuf + _head, oldsize);
+			if (_pbuf) {
+				if (_bmap)
+					unmapring_(_pbuf, _bufsize);
+				else
+					free_(_pbuf);
+			}
+			_pbuf = pnew;
+			_bufsize = newbufsize;
+			_bmap = true;
+			_head = 0;
+			_tail = oldsize;
+			return true;
+		}
+
+		bool unring_(size_t size) // move data to a heap buffer with capacity size at least, leave ring mode
+		{
+			size_t oldsize = _tail - _head, newbufsize = 0;
+			uint8_t* pnew = (uint8_t*)malloc_(size > oldsize ? size : oldsize, newbufsize);
+			if (!pnew)
+				return false;
+			if (oldsize)
+				memcpy(pnew, _pbuf + _head, oldsize);
+			unmapring_(_pbuf, _bufsize);
+			_pbuf = pnew;
+			_bufsize = newbufsize;
+			_bmap = false;
+			_ringsize = 0;
+			_head = 0;
+			_tail = oldsize;
+			return true;
+		}
+
+		bool grow_(size_t size) // grow to hold size more bytes at tail, data moved to the beginning
+		{
+			size_t oldsize = _tail - _head;
+			if (_bmap) {
+				size_t newbufsize = oldsize + size;
+				newbufsize += newbufsize / 2;
+				return remap_(newbufsize) || unring_(newbufsize); // e.g. no fd left for memfd, fall back to normal mode
+			}
+			if (_head) {
+				memmove(_pbuf, _pbuf + _head, oldsize);
+				_head = 0;
+				_tail = oldsize;
+			}
+			size_t newbufsize = oldsize + size; //空间不够,重新分配1.5倍空间
+			newbufsize += newbufsize / 2;
+			uint8_t* pnew = (uint8_t*)::get_ec_allocator()->realloc_(_pbuf, newbufsize, &newbufsize); // big buffer grow by mremap
+			if (!pnew)
+				return false;
+			_bufsize = newbufsize;
+			_pbuf = pnew;
+			return true;
+		}
 	public:
 		inline size_t size_() //数据长度
 		{
@@ -386,7 +583,7 @@ namespace ec {
 		{
 			if (!pdata || !size)
 				return 0;
-			if (!_pbuf) {
+			if (!_pbuf && !_ringsize) {
 				_pbuf = (uint8_t*)malloc_(size + size / 2, _bufsize);
 				if (_pbuf) {
 					memcpy(_pbuf, pdata, size);
@@ -397,26 +594,11 @@ namespace ec {
 				}
 				return -1;
 			}
-			if (_tail + size <= _bufsize) {
-				memcpy(_pbuf + _tail, pdata, size);
-				_tail += size;
-				return 0;
-			}
-
-			//空间不够,重新分配1.5倍空间
-			size_t oldsize = _tail - _head;
-			size_t newbufsize = oldsize + size;
-			newbufsize += newbufsize / 2;
-			uint8_t* pnew = (uint8_t*)malloc_(newbufsize, newbufsize);
-			if (!pnew)
+			void* pw = reserve(size);
+			if (!pw)
 				return -1;
-			memcpy(pnew, _pbuf + _head, oldsize);
-			memcpy(pnew + oldsize, pdata, size);
-			_head = 0;
-			_tail = oldsize + size;
-			_bufsize = newbufsize;
-			free_(_pbuf);
-			_pbuf = pnew;
+			memcpy(pw, pdata, size);
+			_tail += size;
 			return 0;
 		}
 
@@ -425,6 +607,68 @@ namespace ec {
 			return _pbuf + _head;
 		}
 
+		/**
+		 * @brief reserve space at tail for writing directly, such as recv() into the buffer
+		 * @param size bytes to reserve
+		 * @return write position; nullptr: memory error
+		 * @remark call commit() after written, the pointer is invalid after other modify.
+		*/
+		void* reserve(size_t size)
+		{
+			if (!_pbuf && _ringsize && remap_(size)) {
+				_pos = 0;
+				return _pbuf;
+			}
+			if (!_pbuf) {
+				_pbuf = (uint8_t*)malloc_(size, _bufsize);
+				if (!_pbuf)
+					return nullptr;
+				_pos = 0;
+				_head = 0;
+				_tail = 0;
+				return _pbuf;
+			}
+			if (_bmap) { // the space after _tail is continuous in mirror
+				if (_tail - _head + size <= _bufsize)
+					return _pbuf + _tail;
+				return grow_(size) ? _pbuf + _tail : nullptr;
+			}
+			if (_tail + size <= _bufsize)
+				return _pbuf + _tail;
+			size_t oldsize = _tail - _head;
+			if (oldsize + size <= _bufsize) { //move data to the beginning
+				memmove(_pbuf, _pbuf + _head, oldsize);
+				_head = 0;
+				_tail = oldsize;
+				return _pbuf + _tail;
+			}
+			if (!grow_(size))
+				return nullptr;
+			return _pbuf + _tail;
+		}
+
+		/**
+		 * @brief commit size bytes written to the space from reserve()
+		 * @param size bytes written, 0 will free the empty buffer
+		*/
+		void commit(size_t size)
+		{
+			if (!_pbuf)
+				return;
+			_tail += size;
+			size_t zmax = _bmap ? _head + _bufsize : _bufsize;
+			if (_tail > zmax)
+				_tail = zmax;
+			if (_head == _tail) {
+				if (_bmap && _bufsize <= EC_PARSEBUF_RING_KEEPSIZE) {
+					_head = 0;
+					_tail = 0;
+					return;
+				}
+				free();
+			}
+		}
+
 		void freehead(size_t size) //从头释放size字节
 		{
 			if (!_pbuf)
@@ -433,10 +677,21 @@ namespace ec {
 			if (_head >= _tail) {
 				_head = 0;
 				_tail = 0;
+				if (_bmap && _bufsize <= EC_PARSEBUF_RING_KEEPSIZE) // keep the ring buffer
+					return;
+				if (_bmap) {
+					unmapring_(_pbuf, _bufsize);
+					_bmap = false;
+				}
+				else
+					free_(_pbuf);
 				_bufsize = 0;
-				free_(_pbuf);
 				_pbuf = nullptr;
 			}
+			else if (_bmap && _head >= _bufsize) { // wrap in the mirror
+				_head -= _bufsize;
+				_tail -= _bufsize;
+			}
 		}
 
 		void free()//全部释放并释放缓冲区
@@ -444,13 +699,54 @@ namespace ec {
 			if (_pbuf) {
 				_head = 0;
 				_tail = 0;
-				_bufsize = 0;
 				_pos = 0;
-				free_(_pbuf);
+				if (_bmap) {
+					unmapring_(_pbuf, _bufsize);
+					_bmap = false;
+				}
+				else
+					free_(_pbuf);
+				_bufsize = 0;
 				_pbuf = nullptr;
 			}
 		}
 
+		/**
+		 * @brief use ring mode, a double mapped buffer (memfd mirror) in linux, the data is always continuous
+		 *  from data_() without compaction move, and no realloc copy while size_() + reserve size <= capacity.
+		 * @param capacity min capacity, rounded up to page size; 0: back to normal mode, the data is moved to a heap buffer now
+		 * @return true: ring mode, the ring buffer is mapped; false: capacity is 0, not support or map failed, normal mode
+		 * @remark if a later remap failed (e.g. no fd left for memfd), the buffer falls back to normal mode, see isring()
+		*/
+		bool setring(size_t capacity)
+		{
+			_ringsize = capacity;
+			if (!_ringsize) {
+				if (_bmap && _head == _tail)
+					free();
+				else if (_bmap)
+					unring_(_tail - _head);
+				return false;
+			}
+			if (_bmap)
+				return true;
+			if (!remap_(_tail - _head)) { // map now, not at the first reserve, so the result is the actual mode
+				_ringsize = 0;
+				return false;
+			}
+			return true;
+		}
+
+		inline bool isring() const // the buffer is a double mapped ring buffer now
+		{
+			return _bmap;
+		}
+
+		inline size_t capacity() const
+		{
+			return _bufsize;
+		}
+
 		static bool is_be() // is big endian
 		{
 			union {
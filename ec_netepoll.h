@@ -4,6 +4,15 @@
 * 
 * @author jiangyong
 * @update
+	2026-10-17 udp batches use udpbatch_ in ec_aioudp.h, shared with ec_neturing.h
+	2026-10-17 add tcpnodelay()
+	2026-10-17 sendbuf continue the zero-copy send job (sendfile) when _sndbuf is empty
+	2026-10-17 sendbuf use sendmsg gathered send of io_buffer blocks, up to EC_AIO_SNDIOVS blocks once
+	2026-10-17 recv directly into the session parse buffer, see onReceivedRbuf
+	2026-10-17 accept until EAGAIN, udp receive and send use recvmmsg/sendmmsg in batches
+	2026-10-17 receive flow control only check the paused sessions, remove the 5ms full scan, resume at send buffer drained
+	2026-10-17 add EPOLLET mode (EC_AIO_EPOLLET) for tcp sessions, cache interest mask, only call epoll_ctl when it changed
+	2026-10-17 add eventfd wakeup and fd space for multi-reactor
 	2023-12-21 增加总收发流量和总收发秒流量
 	2023-6-15 add tcp keepalive
 	2023-6-6  增加可持续fd, update closefd() 可选通知
@@ -19,6 +28,7 @@ You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2
 #pragma once
 #include "ec_aiolinux.h"
 #include "ec_aiosession.h"
+#include "ec_aioudp.h"
 #include "ec_memory.h"
 #include "ec_log.h"
 #include "ec_map.h"
@@ -27,6 +37,14 @@ You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2
 #define SIZE_MAX_FD  16384 //最大fd连接数
 #endif
 
+#ifndef EC_AIO_SNDIOVS
+#define EC_AIO_SNDIOVS 64 // max io_buffer blocks per sendmsg
+#endif
+
+#ifndef EC_AIO_EPOLLET
+#define EC_AIO_EPOLLET 0 // 1: edge-triggered, read and accept until EAGAIN; 0: level-triggered
+#endif
+
 namespace ec {
 	namespace aio {
 		using NETIO = netio_linux;
@@ -36,13 +54,17 @@ namespace ec {
 			ec::ilog* _plog;
 
 			int _fdepoll;
+			int _fdwakeup; // eventfd kfd, wakeup epoll_wait from other threads
+			int _sysfdwakeup; // system fd of _fdwakeup, used by wakeup() in other threads
 			NETIO _net;
 
 		private:
 			int _lastwaiterr;
 			struct epoll_event _fdevts[EC_AIO_EVTS];
+			udpbatch_ _udp; // recvmmsg/sendmmsg in batches
 		protected:
 			char _recvtmp[EC_AIO_READONCE_SIZE];
+			bool _rbufrecv; // recv directly into _rbuf of the session which rbufrecv() return true, set by the subclass implemented onReceivedRbuf()
 
 		protected:
 			/**
@@ -66,6 +88,16 @@ namespace ec {
 			*/
 			virtual int onReceived(int kfd, const void* pdata, size_t size) = 0;
 
+			/**
+			 * @brief received data directly into the parse buffer of session, used when _rbufrecv and session::rbufrecv()
+			 * @param kfd keyfd
+			 * @param size  Received data size, already committed to _rbuf
+			 * @return 0:OK; -1:error
+			*/
+			virtual int onReceivedRbuf(int kfd, size_t size) {
+				return -1;
+			}
+
 			/**
 			 * @brief received UDP data
 			 * @param kfd keyfd
@@ -114,6 +146,11 @@ namespace ec {
 
 			virtual void onSendtoFailed(int kfd, const struct sockaddr* paddr, int addrlen, const void* pdata, size_t datasize, int errcode) {};
 			virtual void onSendCompleted(int kfd, size_t size) {};
+
+			/**
+			 * @brief wakeup by other thread call wakeup(), run in the epoll thread.
+			*/
+			virtual void onWakeup() {};
 		protected:
 			inline int setsendbuf(int fd, int n)
 			{
@@ -144,11 +181,19 @@ namespace ec {
 				return 0;
 			}
 
+			/**
+			 * @brief epoll events of tcp session when add to epoll
+			*/
+			static inline uint32_t tcpevents_()
+			{
+				return EC_AIO_EPOLLET ? EPOLLIN | EPOLLOUT | EPOLLERR | EPOLLET : EPOLLIN | EPOLLOUT | EPOLLERR;
+			}
+
 			int epoll_add_tcpout(int kfd)
 			{
 				struct epoll_event evt;
 				memset(&evt, 0, sizeof(evt));
-				evt.events = EPOLLIN | EPOLLOUT | EPOLLERR;
+				evt.events = tcpevents_();
 				evt.data.fd = kfd;
 				int nerr = 0;
 				if (0 != (nerr = _net.epoll_ctl_(_fdepoll, EPOLL_CTL_ADD, kfd, &evt))) {
@@ -163,16 +208,40 @@ namespace ec {
 			{
 				return _net.setkeepalive(fd, bfast) >= 0;
 			}
+
+			inline bool tcpnodelay(int fd)
+			{
+				return _net.tcpnodelay(fd) >= 0;
+			}
 		public:
-			serverepoll_(ec::ilog* plog) : _plog(plog), _fdepoll(-1), _lastwaiterr(-100)
+			serverepoll_(ec::ilog* plog) : _plog(plog), _fdepoll(-1), _fdwakeup(-1), _sysfdwakeup(-1), _lastwaiterr(-100)
+				, _rbufrecv(false)
 			{
 			}
 			virtual ~serverepoll_() {
-
 			}
 			inline void SetFdFile(const char* sfile) {
 				_net.SetFdFile(sfile);
 			}
+
+			/**
+			 * @brief set fd space for multi-reactor, call before open()
+			 * @param nid reactor id
+			 * @param nspaces number of reactors
+			*/
+			inline void setfdspace(int nid, int nspaces) {
+				_net.setfdspace(nid, nspaces);
+			}
+
+			/**
+			 * @brief wakeup epoll_wait, thread safe. will call onWakeup() in the epoll thread.
+			*/
+			void wakeup()
+			{
+				if (_sysfdwakeup >= 0)
+					eventfd_write(_sysfdwakeup, 1);
+			}
+
 			//create epoll, return 0:ok; -1:error
 			int open()
 			{
@@ -183,6 +252,20 @@ namespace ec {
 					_plog->add(CLOG_DEFAULT_ERR, "epoll_create_ failed.");
 					return -1;
 				}
+				_fdwakeup = _net.create_eventfd_();
+				if (_fdwakeup >= 0) {
+					struct epoll_event evt;
+					memset(&evt, 0, sizeof(evt));
+					evt.events = EPOLLIN | EPOLLERR;
+					evt.data.fd = _fdwakeup;
+					if (_net.epoll_ctl_(_fdepoll, EPOLL_CTL_ADD, _fdwakeup, &evt)) {
+						_plog->add(CLOG_DEFAULT_ERR, "epoll add eventfd failed.");
+						_net.close_(_fdwakeup);
+						_fdwakeup = -1;
+					}
+					else
+						_sysfdwakeup = _net.getsysfd(_fdwakeup);
+				}
 				_plog->add(CLOG_DEFAULT_MSG, "epoll_create_ success.");
 				return 0;
 			}
@@ -210,15 +293,18 @@ namespace ec {
 				if (_fdepoll >= 0)
 					_net.close_(_fdepoll);
 				_fdepoll = -1;
+				_fdwakeup = -1;
+				_sysfdwakeup = -1;
 			}
 
 			/**
 			 * @brief tcp listen
 			 * @param port port
 			 * @param sip  ipv4 or ipv6, nullptr or empty is ipv4 0.0.0.0
+			 * @param reuseport set SO_REUSEPORT, used by multi-reactor, each reactor listen the same port.
 			 * @return virtual fd; -1:failed
 			*/
-			int tcplisten(uint16_t port, const char* sip = nullptr, int ipv6only = 0)
+			int tcplisten(uint16_t port, const char* sip = nullptr, int ipv6only = 0, int reuseport = 0)
 			{
 				ec::net::socketaddr netaddr;
 				if (netaddr.set(port, sip) < 0)
@@ -227,7 +313,7 @@ namespace ec {
 				struct sockaddr* paddr = netaddr.getsockaddr(&addrlen);
 				if (!paddr)
 					return -1;
-				int fdl = _net.bind_listen(paddr, addrlen, ipv6only);
+				int fdl = _net.bind_listen(paddr, addrlen, ipv6only, reuseport);
 				if (fdl < 0) {
 					_plog->add(CLOG_DEFAULT_ERR, "bind listen tcp://%s:%u failed.", netaddr.viewip(), port);
 					return -1;
@@ -236,7 +322,7 @@ namespace ec {
 
 				struct epoll_event evt;
 				memset(&evt, 0, sizeof(evt));
-				evt.events = EPOLLIN | EPOLLERR;
+				evt.events = EPOLLIN | EPOLLERR; // level-triggered in EPOLLET mode too, pending connections trigger again after EMFILE
 				evt.data.fd = fdl;
 
 				int nerr = 0;
@@ -283,11 +369,8 @@ namespace ec {
 				if (-1 == _fdepoll)
 					return;
 
-				int64_t curmstime = ec::mstime();
-				if (llabs(curmstime - _lastmstime) >= 5) { //5毫秒处理一次接收流控
+				if (!_rdpendings.empty()) // paused by the work of last loop, e.g. the messages in _rbuf or setreadpause()
 					dorecvflowctrl();
-					_lastmstime = curmstime;
-				}
 
 				int nret = _net.epoll_wait_(_fdepoll, _fdevts, static_cast<int>(sizeof(_fdevts) / sizeof(struct epoll_event)), waitmsec);
 				if (nret < 0) {
@@ -336,7 +419,7 @@ namespace ec {
 				psession pss = getSession(kfd);
 				if (!pss)
 					return -1;
-				if ((ns = sendbuf(pss)) < 0) {
+				if ((ns = EC_AIO_EPOLLET ? sendjob_et(pss) : sendbuf(pss)) < 0) {
 					closefd(kfd);
 					return -1;
 				}
@@ -368,19 +451,58 @@ namespace ec {
 				return _net.getbufsize(fd, op);
 			}
 		private:
-			int64_t _lastmstime = 0;//上次扫描可发送的时间，单位GMT毫秒
-			void dorecvflowctrl()//接收流控
+			ec::vector<int> _rdpendings; //paused sessions, stopped reading by sizeCanRecv() or _readpause
+			ec::vector<int> _rdchecks; //swap with _rdpendings in dorecvflowctrl
+
+			void setrdpending(psession pss)
 			{
-				for (auto& i : _net.getmap()) {
-					if (i.fdtype != _net.fd_listen && i.fdtype != _net.fd_epoll && i.fdtype != _net.fd_udp) {
-						triger_evt(getSession(i.kfd));
+				if (!pss->_rdpending) {
+					pss->_rdpending = 1;
+					_rdpendings.push_back(pss->_fd);
+				}
+			}
+
+			void dorecvflowctrl()//接收流控, only check the paused sessions
+			{
+				psession pss;
+				_rdchecks.swap(_rdpendings);
+				for (auto& i : _rdchecks) {
+					pss = getSession(i);
+					if (!pss || !pss->_rdpending) //closed or removed
+						continue;
+					if (pss->_readpause || !sizeCanRecv(pss)) {
+						_rdpendings.push_back(i);
+						continue;
 					}
+					pss->_rdpending = 0;
+					if (EC_AIO_EPOLLET)
+						doread_et(i);
+					else
+						triger_evt(pss);
 				}
+				_rdchecks.clear();
+			}
+
+			/**
+			 * @brief resume the paused reading at EPOLLOUT when the send buffer drained, no wait for the next loop
+			 * @param kfd keyfd
+			 * @return 0: ok; -1: error and closed
+			*/
+			int resumeread(int kfd)
+			{
+				psession pss = getSession(kfd);
+				if (!pss || !pss->_rdpending || !pss->_sndbuf.empty() || pss->_readpause || !sizeCanRecv(pss))
+					return 0;
+				pss->_rdpending = 0; // removed from _rdpendings in dorecvflowctrl
+				if (EC_AIO_EPOLLET)
+					return doread_et(kfd);
+				triger_evt(pss);
+				return 0;
 			}
 
 			void triger_evt(psession pss)
 			{
-				if (!pss)
+				if (EC_AIO_EPOLLET || !pss) // edge-triggered mode never modify the interest mask
 					return;
 				struct epoll_event evtmod;
 				memset(&evtmod, 0, sizeof(evtmod));
@@ -388,13 +510,19 @@ namespace ec {
 
 				if (sizeCanRecv(pss) > 0 && !pss->_readpause)
 					evtmod.events |= EPOLLIN;
+				else
+					setrdpending(pss);
 				if (!pss->_sndbuf.empty() || pss->_status == EC_AIO_FD_CONNECTING || pss->hasSendJob())
 					evtmod.events |= EPOLLOUT;
+				if (evtmod.events == pss->_epollevents)
+					return;
 				evtmod.data.fd = pss->_fd;
 
 				int nerr = 0;
 				if (0 != (nerr = _net.epoll_ctl_(_fdepoll, EPOLL_CTL_MOD, pss->_fd, &evtmod)))
 					_plog->add(CLOG_DEFAULT_ERR, "epoll_ctrl_ EPOLL_CTL_MOD failed @onevent. fd = %d,  error = %d", pss->_fd, nerr);
+				else
+					pss->_epollevents = evtmod.events;
 			}
 
 			void udp_sendto(int kfd)
@@ -409,60 +537,23 @@ namespace ec {
 					udp_trigger(kfd, 0);
 					return;
 				}
-				int numsnd = 0, nbytes = 0;
-				do {
-					auto& frm = pfrms->front();
-					if (!frm.empty()) {
-						if (_net.sendto_(kfd, frm.data(), frm.size(), frm.getnetaddr(), frm.netaddrlen()) < 0) {
-							if(numsnd)
-								pss->onUdpSendCount(numsnd, nbytes);
-							if (EAGAIN != errno)
-								onSendtoFailed(kfd, frm.getnetaddr(), frm.netaddrlen(), frm.data(), frm.size(), errno);
-							pfrms->pop();
-							return;
-						}
-#ifdef _DEBUG
-						if (_plog->getlevel() >= CLOG_DEFAULT_ALL) {
-							ec::net::socketaddr peeraddr;
-							peeraddr.set(frm.getnetaddr(), frm.netaddrlen());
-							_plog->add(CLOG_DEFAULT_ALL, "fd(%d) sento %s:%u %zu bytes.", kfd,
-								peeraddr.viewip(), peeraddr.port(), frm.size());
-						}
-#endif
-						nbytes += (int)frm.size();
-					}
-					pfrms->pop();
-					numsnd++;
-				} while (!pfrms->empty() && numsnd < 16 && nbytes < 1024 * 32);
-				pss->onUdpSendCount(numsnd, nbytes);
-				onSendCompleted(kfd, nbytes);
+				int nbytes = 0;
+				int numsnd = _udp.sendto(_net, kfd, pfrms, _plog, nbytes, [&](udp_frm_& frm, int errcode) {
+					onSendtoFailed(kfd, frm.getnetaddr(), frm.netaddrlen(), frm.data(), frm.size(), errcode);
+				});
+				if (numsnd) {
+					pss->onUdpSendCount(numsnd, nbytes);
+					onSendCompleted(kfd, nbytes);
+				}
 			}
 
-			char udpbuf_[1024 * 64] = { 0 };
 			void onudpevent(struct epoll_event& evt)
 			{
 				if (evt.events & EPOLLIN) {
-					int nr = -1, ndo = 64;
-					socklen_t* paddrlen = nullptr;
-					ec::net::socketaddr addr;
-					struct sockaddr* paddr = addr.getbuffer(&paddrlen);
-					do {
-						nr = _net.recvfrom_(evt.data.fd, udpbuf_, (int)sizeof(udpbuf_), 0, paddr, paddrlen);
-						if (nr > 0) {
-#ifdef _DEBUG
-							if (_plog->getlevel() >= CLOG_DEFAULT_ALL) {
-								_plog->add(CLOG_DEFAULT_ALL, "fd(%d) recvfrom %s:%u %d bytes.", evt.data.fd,
-									addr.viewip(), addr.port(), nr);
-							}
-#endif
-							if (onReceivedFrom(evt.data.fd, udpbuf_, nr, paddr, *paddrlen) < 0)
-								break;
-						}
-						else if (nr < 0 && EAGAIN != errno) {
-							_plog->add(CLOG_DEFAULT_ERR, "fd(%d) recvfrom failed. error %d", evt.data.fd, errno);
-						}
-						--ndo;
-					} while (nr > 0 && ndo > 0);
+					int kfd = evt.data.fd;
+					_udp.recvfrom(_net, kfd, _plog, [&](const void* pdata, size_t size, const struct sockaddr* addrfrom, int addrlen) {
+						return onReceivedFrom(kfd, pdata, size, addrfrom, addrlen);
+					});
 				}
 				if (evt.events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
 					_plog->add(CLOG_DEFAULT_DBG, "udp fd(%d)  error events %08XH", evt.data.fd, evt.events);
@@ -481,46 +572,31 @@ namespace ec {
 					onudpevent(evt);
 					return;
 				}
+				if (nfdtype == _net.fd_event) {
+					_net.read_eventfd_(evt.data.fd);
+					onWakeup();
+					return;
+				}
 				if ((evt.events & EPOLLIN) && _net.fd_listen == nfdtype) {
 #ifdef _DEBUG
 					_plog->add(CLOG_DEFAULT_ALL, "listen fd(%d)  EPOLLIN, events %08XH", evt.data.fd, evt.events);
 #endif
-					ec::net::socketaddr clientaddr;
-					socklen_t* paddrlen = nullptr;
-					struct sockaddr* paddr = clientaddr.getbuffer(&paddrlen);
-					int fdc = _net.accept_(evt.data.fd, paddr, paddrlen);
-					if (fdc >= 0) {
-						int nerr = 0;
-						struct epoll_event ev;
-						memset(&ev, 0, sizeof(ev));
-						ev.events = EPOLLIN | EPOLLOUT | EPOLLERR;
-						ev.data.fd = fdc;
-						if (0 != (nerr = _net.epoll_ctl_(_fdepoll, EPOLL_CTL_ADD, fdc, &ev))) {
-							_plog->add(CLOG_DEFAULT_ERR, "epoll_ctrl_ EPOLL_CTL_ADD failed @onconnect_in. fd = %d, error = %d", fdc, nerr);
-							_net.close_(fdc);
-						}
-						else {
-							uint16_t uport = 0;
-							char sip[48] = { 0 };
-							clientaddr.get(uport, sip, sizeof(sip));
-							_plog->add(CLOG_DEFAULT_INF, "fd(%d) accept from %s:%u at listen fd(%d)",
-								fdc, clientaddr.viewip(), uport, evt.data.fd);
-							onAccept(fdc, sip, uport, evt.data.fd);
-						}
-					}
-					else
-						_plog->add(CLOG_DEFAULT_ERR, "accept failed. listen fd = %d", evt.data.fd);
+					while (doaccept(evt.data.fd) >= 0) // accept until EAGAIN
+						;
 					return;
 				}
-				if (evt.events & EPOLLIN) {
+				if ((evt.events & EPOLLIN) && EC_AIO_EPOLLET) {
+					if (doread_et(evt.data.fd) < 0)
+						return;
+				}
+				else if (evt.events & EPOLLIN) {
 					int nr = -1;
 					psession pss = getSession(evt.data.fd);
 					if (pss && !pss->_readpause) {
 						size_t zr = sizeCanRecv(pss);
 						if (zr > 0) {
-							if (zr > sizeof(_recvtmp))
-								zr = sizeof(_recvtmp);
-							nr = _net.recv_(evt.data.fd, _recvtmp, zr, 0);
+							bool brbuf = false;
+							nr = recvonce(pss, zr, brbuf);
 							if (!nr || (nr < 0 && EAGAIN != _net.geterrno() && EWOULDBLOCK != _net.geterrno())) {
 								closefd(evt.data.fd);
 								return;
@@ -528,7 +604,7 @@ namespace ec {
 #ifdef _DEBUG
 							_plog->add(CLOG_DEFAULT_ALL, "fd(%d) received %d bytes", evt.data.fd, nr);
 #endif
-							if (nr > 0 && onReceived(evt.data.fd, _recvtmp, nr) < 0) {
+							if (nr > 0 && (brbuf ? onReceivedRbuf(evt.data.fd, nr) : onReceived(evt.data.fd, _recvtmp, nr)) < 0) {
 								closefd(evt.data.fd);
 								return;
 							}
@@ -547,10 +623,136 @@ namespace ec {
 					if (onepollout(evt.data.fd) < 0)
 						return;
 				}
-				if (NETIO::fd_listen != nfdtype && NETIO::fd_epoll != nfdtype)
+				if (!EC_AIO_EPOLLET && NETIO::fd_listen != nfdtype && NETIO::fd_epoll != nfdtype)
 					sendtrigger(evt.data.fd);
 			}
 
+			/**
+			 * @brief accept one connection and add to epoll
+			 * @param kfdlisten keyfd of listened
+			 * @return >=0: continue to accept; -1: no more connection or error
+			*/
+			int doaccept(int kfdlisten)
+			{
+				ec::net::socketaddr clientaddr;
+				socklen_t* paddrlen = nullptr;
+				struct sockaddr* paddr = clientaddr.getbuffer(&paddrlen);
+				int fdc = _net.accept_(kfdlisten, paddr, paddrlen);
+				if (fdc < 0) {
+					if (ECONNABORTED == errno || EINTR == errno || EPROTO == errno)
+						return 0;
+					if (EAGAIN != errno && EWOULDBLOCK != errno)
+						_plog->add(CLOG_DEFAULT_ERR, "accept failed. listen fd = %d, error = %d", kfdlisten, errno);
+					return -1;
+				}
+				int nerr = 0;
+				struct epoll_event ev;
+				memset(&ev, 0, sizeof(ev));
+				ev.events = tcpevents_();
+				ev.data.fd = fdc;
+				if (0 != (nerr = _net.epoll_ctl_(_fdepoll, EPOLL_CTL_ADD, fdc, &ev))) {
+					_plog->add(CLOG_DEFAULT_ERR, "epoll_ctrl_ EPOLL_CTL_ADD failed @onconnect_in. fd = %d, error = %d", fdc, nerr);
+					_net.close_(fdc);
+					return fdc;
+				}
+				uint16_t uport = 0;
+				char sip[48] = { 0 };
+				clientaddr.get(uport, sip, sizeof(sip));
+				_plog->add(CLOG_DEFAULT_INF, "fd(%d) accept from %s:%u at listen fd(%d)",
+					fdc, clientaddr.viewip(), uport, kfdlisten);
+				onAccept(fdc, sip, uport, kfdlisten);
+				psession pss = getSession(fdc);
+				if (pss)
+					pss->_epollevents = ev.events;
+				return fdc;
+			}
+
+			/**
+			 * @brief recv once into the parse buffer of session if it can, else into _recvtmp
+			 * @param pss
+			 * @param zr size to read
+			 * @param brbuf [out] true: received into pss->_rbuf and committed
+			 * @return the same as recv
+			*/
+			int recvonce(psession pss, size_t zr, bool& brbuf)
+			{
+				if (zr > sizeof(_recvtmp))
+					zr = sizeof(_recvtmp);
+				brbuf = _rbufrecv && pss->rbufrecv();
+				if (!brbuf)
+					return _net.recv_(pss->_fd, _recvtmp, zr, 0);
+				void* pbuf = pss->_rbuf.reserve(zr);
+				if (!pbuf) {
+					_plog->add(CLOG_DEFAULT_ERR, "fd(%d) parse buffer reserve %zu bytes failed.", pss->_fd, zr);
+					errno = ENOMEM;
+					return -1;
+				}
+				int nr = _net.recv_(pss->_fd, pbuf, zr, 0);
+				pss->_rbuf.commit(nr > 0 ? (size_t)nr : 0);
+				return nr;
+			}
+
+			/**
+			 * @brief EPOLLET mode, read until EAGAIN. if can not receive now, add to paused sessions and read again in dorecvflowctrl
+			 * @param kfd keyfd
+			 * @return 0: ok; -1: error and closed
+			*/
+			int doread_et(int kfd)
+			{
+				int nr;
+				size_t zr;
+				bool brbuf;
+				psession pss = getSession(kfd);
+				while (pss) {
+					if (pss->_readpause || !(zr = sizeCanRecv(pss))) {
+						setrdpending(pss);
+						break;
+					}
+					pss->_rdpending = 0;
+					if (zr > sizeof(_recvtmp))
+						zr = sizeof(_recvtmp);
+					nr = recvonce(pss, zr, brbuf);
+					if (nr < 0 && (EAGAIN == _net.geterrno() || EWOULDBLOCK == _net.geterrno()))
+						break;
+					if (nr <= 0) {
+						closefd(kfd);
+						return -1;
+					}
+#ifdef _DEBUG
+					_plog->add(CLOG_DEFAULT_ALL, "fd(%d) received %d bytes", kfd, nr);
+#endif
+					if ((brbuf ? onReceivedRbuf(kfd, nr) : onReceived(kfd, _recvtmp, nr)) < 0) {
+						closefd(kfd);
+						return -1;
+					}
+					if (nr < (int)zr) // system buffer is empty, the next data will trigger a new edge.
+						break;
+					pss = getSession(kfd); // the session may be replaced by protocol upgrading in onReceived
+				}
+				return 0;
+			}
+
+			/**
+			 * @brief EPOLLET mode, send until system buffer full or no more send job.
+			 * @param pss
+			 * @return bytes sent; -1:error
+			 * @remark EPOLLOUT is edge-triggered, continue the send job (e.g. http download big file) here.
+			*/
+			int sendjob_et(psession pss)
+			{
+				int ns, nsnd = 0;
+				do {
+					if ((ns = sendbuf(pss)) < 0)
+						return -1;
+					nsnd += ns;
+					if (!pss->_sndbuf.empty())
+						break;
+					if (!pss->onSendCompleted())
+						return -1;
+				} while (!pss->_sndbuf.empty());
+				return nsnd;
+			}
+
 			int onepollout(int kfd)
 			{
 				psession pss = getSession(kfd);
@@ -571,6 +773,13 @@ namespace ec {
 						return 0;
 					}
 				}
+				if (EC_AIO_EPOLLET) {
+					if (sendjob_et(pss) < 0) {
+						closefd(kfd);
+						return -1;
+					}
+					return resumeread(kfd);
+				}
 				if (sendbuf(pss) < 0) {
 					closefd(kfd);
 					return -1;
@@ -581,7 +790,7 @@ namespace ec {
 						return -1;
 					}
 				}
-				return 0;
+				return resumeread(kfd);
 			}
 
 			/**
@@ -597,14 +806,15 @@ namespace ec {
 				if (pdata && size)
 					pss->_sndbuf.append((const uint8_t*)pdata, size);
 
-				const void* pd = nullptr;
+				struct iovec iovs[EC_AIO_SNDIOVS];
 				size_t zlen = 0;
-
-				pd = pss->_sndbuf.get(zlen);
-				while (pd && zlen) {
-					ns = _net.send_(fd, pd, (int)(zlen), 0);
+				int i, niov = pss->_sndbuf.peekiov(iovs, EC_AIO_SNDIOVS);
+				while (niov > 0) {
+					for (i = 0, zlen = 0; i < niov; i++)
+						zlen += iovs[i].iov_len;
+					ns = niov > 1 ? _net.sendiov_(fd, iovs, niov, 0) : _net.send_(fd, iovs[0].iov_base, zlen, 0);
 #ifdef _DEBUG
-					_plog->add(CLOG_DEFAULT_ALL, "sendbuf fd(%d) size %d", fd, ns);
+					_plog->add(CLOG_DEFAULT_ALL, "sendbuf fd(%d) blocks %d size %d", fd, niov, ns);
 #endif
 					if (ns < 0) {
 						int nerr = _net.geterrno();
@@ -617,10 +827,16 @@ namespace ec {
 					else if (!ns)
 						break;
 					nsnd += ns;
-					pss->_sndbuf.freesize(ns);
+					pss->_sndbuf.freesize(ns); // partial write frees the sent blocks and moves pos of the next
 					if (ns < (int)(zlen))
 						break;
-					pd = pss->_sndbuf.get(zlen);
+					niov = pss->_sndbuf.peekiov(iovs, EC_AIO_SNDIOVS);
+				}
+				if (ns >= 0 && pss->_sndbuf.empty()) { // zero-copy send job, until system buffer full or job completed
+					while ((ns = pss->sendfilejob(_net.getsysfd(fd))) > 0)
+						nsnd += ns;
+					if (ns < 0)
+						_plog->add(CLOG_DEFAULT_ERR, "fd(%d) sendfilejob failed, syserr %d", fd, _net.geterrno());
 				}
 				if (nsnd) {
 					pss->_allsend += nsnd;
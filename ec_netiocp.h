@@ -3,6 +3,8 @@
 * base net server class use IOCP for windows
 * @author jiangyong
 * @update
+	2026-10-17 add tcpnodelay()
+	2026-10-17 _mapfd use flatmap
 	2023-12-21 增加总收发流量和总收发秒流量
 	2023-6-15 add tcp keepalive
 	2023-6-6  增加可持续fd, update closefd() 可选通知
@@ -142,7 +144,7 @@ namespace ec {
 			ec::ilog* _plog;
 
 			HANDLE _hiocp;
-			ec::hashmap<int, t_fd, keq_fd> _mapfd;
+			ec::flatmap<int, t_fd, keq_fd> _mapfd;
 			int _nextfd; // from 1-INT32_MAX
 			std::string _sfdfile;
 
@@ -367,6 +369,15 @@ namespace ec {
 				return true;
 			}
 
+			bool tcpnodelay(int kfd)
+			{
+				t_fd* p = _mapfd.get(kfd);
+				if (!p)
+					return false;
+				BOOL bNodelay = 1;
+				return SOCKET_ERROR != setsockopt(p->sysfd, IPPROTO_TCP, TCP_NODELAY, (char*)&bNodelay, sizeof(bNodelay));
+			}
+
 		public:
 			serveriocp_(ec::ilog* plog) : _plog(plog), _hiocp(nullptr), _nextfd(0)
 			{
@@ -1119,10 +1130,11 @@ namespace ec {
 					tf.post_snd = 0;
 					tf.post_rcv = 0;
 					tf.sa_family = ptfls->sa_family;
+					SOCKET sysfdlisten = ptfls->sysfd; // ptfls is invalid after _mapfd.set()
 					_mapfd.set(tf.kfd, tf);
 
 					int iResult = 0;
-					iResult = setsockopt(tf.sysfd, SOL_SOCKET, SO_UPDATE_ACCEPT_CONTEXT, (char*)&ptfls->sysfd, sizeof(ptfls->sysfd));
+					iResult = setsockopt(tf.sysfd, SOL_SOCKET, SO_UPDATE_ACCEPT_CONTEXT, (char*)&sysfdlisten, sizeof(sysfdlisten));
 					if (iResult) {
 						_plog->add(CLOG_DEFAULT_ERR, "SO_UPDATE_ACCEPT_CONTEXT failed with error : %d", WSAGetLastError());
 						close_(tf.kfd);
@@ -2,7 +2,8 @@
 \file ec_netss_base.h
 \author	jiangyong
 \email  kipway@outlook.com
-\update 2023-5-21
+\update 2026-10-17
+  2026-10-17 sendbuf use sendmsg gathered send of io_buffer blocks in linux, up to EC_NET_SNDIOVS blocks once
   2023-5-21 support big file http download
   2023-5-13 remove ec::memory
   2023-2-3 upgrade session _ip size for ipv6
@@ -87,6 +88,10 @@ You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2
 #endif
 #endif
 
+#ifndef EC_NET_SNDIOVS // max send buffer blocks per sendmsg in linux
+#	define EC_NET_SNDIOVS 64
+#endif
+
 #ifndef EC_NET_SEND_BLOCK_OVERSECOND // Maximum blocking time(seconds)
 #	define EC_NET_SEND_BLOCK_OVERSECOND 10
 #endif
@@ -390,6 +395,33 @@ namespace ec
 				if (_sndbuf.empty())
 					return 0;
 				int nr = 0, ns;
+#ifndef _WIN32
+				struct iovec iovs[EC_NET_SNDIOVS];
+				struct msghdr msg;
+				size_t zsend;
+				int i, niov = _sndbuf.peekiov(iovs, EC_NET_SNDIOVS);
+				while (niov > 0) {
+					memset(&msg, 0, sizeof(msg));
+					msg.msg_iov = iovs;
+					msg.msg_iovlen = niov;
+					for (i = 0, zsend = 0; i < niov; i++)
+						zsend += iovs[i].iov_len;
+					ns = (int)::sendmsg(_fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+					if (ns < 0) {
+						if (EAGAIN == errno || EWOULDBLOCK == errno)
+							return nr;
+						return -1;
+					}
+					else if (!ns)
+						return nr;
+					_sndbuf.freesize(ns); // partial write frees the sent blocks and moves pos of the next
+					nr += ns;
+					if (ns < (int)zsend)
+						break;
+					niov = _sndbuf.peekiov(iovs, EC_NET_SNDIOVS);
+				}
+				return nr;
+#else
 				const void* pd = nullptr;
 				size_t zlen = 0;
 
@@ -407,6 +439,7 @@ namespace ec
 					pd = _sndbuf.get(zlen);
 				}
 				return nr;
+#endif
 			}
 
 			inline size_t sndbufsize()// Returns the number of bytes in the send buffer
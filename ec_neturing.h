@@ -0,0 +1,1277 @@
+﻿/*
+* @file ec_neturing.h
+* base net server class use io_uring for linux, the same interface as serverepoll_
+*
+* @author jiangyong
+* @update
+	2026-10-17 send buffer of closed fd held until the last send completion, send again when the submission queue was full
+	2026-10-17 resume the paused reading at send buffer drained, remove the 5ms check of paused sessions
+	2026-10-17 add tcpnodelay()
+	2026-10-17 zero-copy send job (sendfile) when _sndbuf is empty, POLLOUT armed when the socket buffer is full
+	2026-10-17 append to the session parse buffer, see onReceivedRbuf
+	2026-10-17 first version, multishot accept, multishot recv with provided buffer ring, linked send
+
+* eclib 3.0 Copyright (c) 2017-2023, kipway
+
+Licensed under the Apache License, Version 2.0 (the "License");
+You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+need Linux 6.0+ (multishot recv and provided buffer ring). raw syscalls, not need liburing.
+tcp and eventfd use io_uring operations, udp use multishot poll then recvmmsg/sendmmsg.
+if the provided buffer ring can not be used (register failed or probe recv return ENOBUFS),
+fall back to IORING_OP_PROVIDE_BUFFERS, recycled buffers are provided in batches once per loop.
+*/
+#pragma once
+#include <poll.h>
+#include <algorithm>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include "ec_aiolinux.h"
+#include "ec_aiosession.h"
+#include "ec_aioudp.h"
+#include "ec_memory.h"
+#include "ec_log.h"
+#include "ec_vector.hpp"
+#ifndef SIZE_MAX_FD
+#define SIZE_MAX_FD  16384 //最大fd连接数
+#endif
+
+#ifndef EC_AIO_URING_ENTRIES
+#define EC_AIO_URING_ENTRIES 1024 // submission queue entries, completion queue entries is double
+#endif
+
+#ifndef EC_AIO_URING_BUFS
+#define EC_AIO_URING_BUFS 256 // provided receive buffers, power of 2, EC_AIO_READONCE_SIZE bytes per buffer
+#endif
+
+#ifndef EC_AIO_URING_SENDLINKS
+#define EC_AIO_URING_SENDLINKS 8 // max linked send operations of one session, one io_buffer block per send
+#endif
+
+namespace ec {
+	namespace aio {
+		using NETIO = netio_linux;
+		/**
+		 * @brief io_uring with one provided buffer group, use raw syscalls
+		*/
+		class uring_
+		{
+		private:
+			int _fd;
+			unsigned _sqmask, _sqentries, _sqtail, _sqpending;
+			unsigned* _ksqhead;
+			unsigned* _ksqtail;
+			unsigned* _ksqarray;
+			unsigned _cqmask;
+			unsigned* _kcqhead;
+			unsigned* _kcqtail;
+			struct io_uring_sqe* _sqes;
+			struct io_uring_cqe* _cqes;
+			void* _pring;
+			size_t _zring;
+			size_t _zsqes;
+
+			struct io_uring_buf_ring* _pbr; // provided buffer ring
+			size_t _zbr;
+			char* _pbufs;
+			size_t _zbufs;
+			size_t _bufsize;
+			unsigned _nbufs;
+			unsigned short _brtail;
+			int _bgid;
+			bool _blegacy; // use IORING_OP_PROVIDE_BUFFERS
+			ec::vector<unsigned short> _bidfree; // legacy mode, buffers wait to provide
+		public:
+			uring_() : _fd(-1), _sqmask(0), _sqentries(0), _sqtail(0), _sqpending(0), _ksqhead(nullptr), _ksqtail(nullptr)
+				, _ksqarray(nullptr), _cqmask(0), _kcqhead(nullptr), _kcqtail(nullptr), _sqes(nullptr), _cqes(nullptr)
+				, _pring(nullptr), _zring(0), _zsqes(0), _pbr(nullptr), _zbr(0), _pbufs(nullptr), _zbufs(0)
+				, _bufsize(0), _nbufs(0), _brtail(0), _bgid(0), _blegacy(false)
+			{
+			}
+			~uring_() {
+				close();
+			}
+			inline bool isopen() const {
+				return _fd >= 0;
+			}
+			inline int bgid() const {
+				return _bgid;
+			}
+			inline bool islegacybuf() const {
+				return _blegacy;
+			}
+			inline char* bufaddr(unsigned bid) {
+				return _pbufs + bid * _bufsize;
+			}
+
+			/**
+			 * @brief create io_uring and provide receive buffers
+			 * @param entries submission queue entries
+			 * @param nbufs number of provided buffers, power of 2
+			 * @param bufsize size of each provided buffer
+			 * @param bgid buffer group id
+			 * @return 0:ok; -1:error
+			*/
+			int open(unsigned entries, unsigned nbufs, size_t bufsize, int bgid)
+			{
+				struct io_uring_params params;
+				memset(&params, 0, sizeof(params));
+				params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+				params.cq_entries = entries * 2;
+				_fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+				if (_fd < 0)
+					return -1;
+				if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG)
+					|| !(params.features & IORING_FEAT_NODROP)) {
+					close();
+					return -1;
+				}
+				size_t zsq = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+				size_t zcq = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+				_zring = zsq > zcq ? zsq : zcq;
+				_pring = mmap(nullptr, _zring, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+				if (MAP_FAILED == _pring) {
+					_pring = nullptr;
+					close();
+					return -1;
+				}
+				_zsqes = params.sq_entries * sizeof(struct io_uring_sqe);
+				_sqes = (struct io_uring_sqe*)mmap(nullptr, _zsqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+				if (MAP_FAILED == _sqes) {
+					_sqes = nullptr;
+					close();
+					return -1;
+				}
+				char* p = (char*)_pring;
+				_ksqhead = (unsigned*)(p + params.sq_off.head);
+				_ksqtail = (unsigned*)(p + params.sq_off.tail);
+				_ksqarray = (unsigned*)(p + params.sq_off.array);
+				_sqmask = *(unsigned*)(p + params.sq_off.ring_mask);
+				_sqentries = params.sq_entries;
+				_sqtail = *_ksqtail;
+				_kcqhead = (unsigned*)(p + params.cq_off.head);
+				_kcqtail = (unsigned*)(p + params.cq_off.tail);
+				_cqmask = *(unsigned*)(p + params.cq_off.ring_mask);
+				_cqes = (struct io_uring_cqe*)(p + params.cq_off.cqes);
+
+				_nbufs = nbufs;
+				_bufsize = bufsize;
+				_bgid = bgid;
+				_zbr = nbufs * sizeof(struct io_uring_buf);
+				_pbr = (struct io_uring_buf_ring*)mmap(nullptr, _zbr, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+				if (MAP_FAILED == _pbr) {
+					_pbr = nullptr;
+					close();
+					return -1;
+				}
+				_zbufs = nbufs * bufsize;
+				_pbufs = (char*)mmap(nullptr, _zbufs, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+				if (MAP_FAILED == _pbufs) {
+					_pbufs = nullptr;
+					close();
+					return -1;
+				}
+				struct io_uring_buf_reg reg;
+				memset(&reg, 0, sizeof(reg));
+				reg.ring_addr = (uint64_t)(uintptr_t)_pbr;
+				reg.ring_entries = nbufs;
+				reg.bgid = (uint16_t)bgid;
+				_blegacy = false;
+				_brtail = 0;
+				if (syscall(__NR_io_uring_register, _fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+					_blegacy = true;
+				else {
+					for (unsigned i = 0; i < nbufs; i++)
+						addbuf(i);
+					if (!probebufring()) {
+						syscall(__NR_io_uring_register, _fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+						_blegacy = true;
+					}
+				}
+				if (_blegacy) {
+					munmap(_pbr, _zbr);
+					_pbr = nullptr;
+					_bidfree.clear();
+					_bidfree.reserve(nbufs);
+					for (unsigned i = 0; i < nbufs; i++)
+						_bidfree.push_back((unsigned short)i);
+					if (flushbufs() < 0 || submit(-1) < 0) {
+						close();
+						return -1;
+					}
+				}
+				return 0;
+			}
+
+			void close()
+			{
+				if (_fd >= 0) {
+					::close(_fd);
+					_fd = -1;
+				}
+				if (_sqes) {
+					munmap(_sqes, _zsqes);
+					_sqes = nullptr;
+				}
+				if (_pring) {
+					munmap(_pring, _zring);
+					_pring = nullptr;
+				}
+				if (_pbr) {
+					munmap(_pbr, _zbr);
+					_pbr = nullptr;
+				}
+				if (_pbufs) {
+					munmap(_pbufs, _zbufs);
+					_pbufs = nullptr;
+				}
+				_sqpending = 0;
+				_bidfree.clear();
+			}
+
+			/**
+			 * @brief give back a provided buffer to kernel
+			 * @param bid buffer id
+			 * @remark legacy mode wait flushbufs()
+			*/
+			void addbuf(unsigned bid)
+			{
+				if (_blegacy) {
+					_bidfree.push_back((unsigned short)bid);
+					return;
+				}
+				struct io_uring_buf* pbuf = &_pbr->bufs[_brtail & (_nbufs - 1)];
+				pbuf->addr = (uint64_t)(uintptr_t)bufaddr(bid);
+				pbuf->len = (uint32_t)_bufsize;
+				pbuf->bid = (uint16_t)bid;
+				++_brtail;
+				__atomic_store_n(&_pbr->tail, _brtail, __ATOMIC_RELEASE);
+			}
+
+			/**
+			 * @brief legacy mode, provide recycled buffers, one IORING_OP_PROVIDE_BUFFERS per consecutive buffer ids
+			 * @return 0:ok; -1:no submission queue entry
+			*/
+			int flushbufs()
+			{
+				if (_bidfree.empty())
+					return 0;
+				std::sort(_bidfree.begin(), _bidfree.end());
+				size_t i = 0, n;
+				struct io_uring_sqe* sqe;
+				while (i < _bidfree.size()) {
+					n = 1;
+					while (i + n < _bidfree.size() && _bidfree[i + n] == _bidfree[i] + n)
+						++n;
+					if (!(sqe = getsqe())) {
+						_bidfree.erase(_bidfree.begin(), _bidfree.begin() + i);
+						return -1;
+					}
+					sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+					sqe->fd = (int)n;
+					sqe->addr = (uint64_t)(uintptr_t)bufaddr(_bidfree[i]);
+					sqe->len = (uint32_t)_bufsize;
+					sqe->off = _bidfree[i];
+					sqe->buf_group = (uint16_t)_bgid;
+					sqe->user_data = 0;
+					i += n;
+				}
+				_bidfree.clear();
+				return 0;
+			}
+
+			/**
+			 * @return number of free submission queue entries
+			*/
+			inline unsigned sqfree()
+			{
+				return _sqentries - (_sqtail - __atomic_load_n(_ksqhead, __ATOMIC_ACQUIRE));
+			}
+
+			/**
+			 * @brief get a zeroed submission queue entry, submit pending entries if full.
+			 * @return nullptr if full
+			*/
+			struct io_uring_sqe* getsqe()
+			{
+				if (!sqfree()) {
+					submit(-1);
+					if (!sqfree())
+						return nullptr;
+				}
+				unsigned idx = _sqtail & _sqmask;
+				struct io_uring_sqe* sqe = &_sqes[idx];
+				memset(sqe, 0, sizeof(*sqe));
+				_ksqarray[idx] = idx;
+				++_sqtail;
+				++_sqpending;
+				__atomic_store_n(_ksqtail, _sqtail, __ATOMIC_RELEASE);
+				return sqe;
+			}
+
+			/**
+			 * @brief submit pending entries and wait completions
+			 * @param waitmsec <0: not wait; 0: not wait; >0 wait at least one completion or timeout
+			 * @return >=0 number submitted; -1 error
+			*/
+			int submit(int waitmsec)
+			{
+				unsigned flags = 0, waitnr = 0;
+				struct __kernel_timespec ts;
+				struct io_uring_getevents_arg arg;
+				memset(&arg, 0, sizeof(arg));
+				if (waitmsec > 0) {
+					ts.tv_sec = waitmsec / 1000;
+					ts.tv_nsec = (waitmsec % 1000) * 1000000LL;
+					arg.sigmask_sz = _NSIG / 8;
+					arg.ts = (uint64_t)(uintptr_t)&ts;
+					flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+					waitnr = 1;
+				}
+				else if (!_sqpending)
+					return 0;
+				int nret = (int)syscall(__NR_io_uring_enter, _fd, _sqpending, waitnr, flags,
+					waitmsec > 0 ? &arg : nullptr, waitmsec > 0 ? sizeof(arg) : 0);
+				if (nret < 0) {
+					if (ETIME == errno || EINTR == errno || EBUSY == errno || EAGAIN == errno)
+						return 0;
+					return -1;
+				}
+				_sqpending = (unsigned)nret < _sqpending ? _sqpending - nret : 0;
+				return nret;
+			}
+
+			/**
+			 * @brief process completion queue entries
+			 * @param fun callback void(const struct io_uring_cqe&)
+			 * @return number of entries processed
+			*/
+			template<class _Fun>
+			unsigned forcqes(_Fun fun)
+			{
+				unsigned n = 0, head = *_kcqhead, tail = __atomic_load_n(_kcqtail, __ATOMIC_ACQUIRE);
+				struct io_uring_cqe cqe;
+				while (head != tail && n <= _cqmask) {
+					cqe = _cqes[head & _cqmask];
+					++head;
+					__atomic_store_n(_kcqhead, head, __ATOMIC_RELEASE); // free the entry before callback
+					fun(cqe);
+					++n;
+					if (head == tail)
+						tail = __atomic_load_n(_kcqtail, __ATOMIC_ACQUIRE);
+				}
+				return n;
+			}
+		private:
+			/**
+			 * @brief recv one byte from socketpair use the buffer ring, some kernels register success but always return ENOBUFS.
+			 * @return true: the buffer ring works
+			*/
+			bool probebufring()
+			{
+				int sv[2];
+				if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0)
+					return false;
+				int res = -1, bid = -1;
+				struct io_uring_sqe* sqe = nullptr;
+				if (1 == ::write(sv[1], "p", 1) && (sqe = getsqe())) {
+					sqe->opcode = IORING_OP_RECV;
+					sqe->fd = sv[0];
+					sqe->flags = IOSQE_BUFFER_SELECT;
+					sqe->buf_group = (uint16_t)_bgid;
+					sqe->user_data = 0;
+					submit(1000);
+					forcqes([&](const struct io_uring_cqe& cqe) {
+						res = cqe.res;
+						if (cqe.flags & IORING_CQE_F_BUFFER)
+							bid = (int)(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+					});
+				}
+				::close(sv[0]);
+				::close(sv[1]);
+				if (bid >= 0)
+					addbuf((unsigned)bid);
+				return 1 == res && bid >= 0;
+			}
+		};
+
+		class serveruring_
+		{
+		protected:
+			ec::ilog* _plog;
+
+			int _fdwakeup; // eventfd kfd, wakeup io_uring_enter from other threads
+			int _sysfdwakeup; // system fd of _fdwakeup, used by wakeup() in other threads
+			NETIO _net;
+			uring_ _ring;
+			bool _rbufrecv; // append to _rbuf of the session which rbufrecv() return true, set by the subclass implemented onReceivedRbuf()
+
+		private:
+			int _lastwaiterr;
+			enum {
+				uop_accept = 1, // multishot accept
+				uop_recv, // multishot recv
+				uop_send, // linked send
+				uop_pollin, // multishot poll POLLIN, udp and eventfd
+				uop_pollout, // poll POLLOUT, udp and tcp zero-copy send job
+				uop_connect, // poll POLLOUT, tcp connect out
+				uop_cancel
+			};
+			enum {
+				uf_recv = 0x01, // multishot recv armed
+				uf_cancel = 0x02, // recv cancel submitted
+				uf_pollout = 0x04, // POLLOUT armed
+				uf_sndwait = 0x08 // in _sndwaits, no submission queue entry for send
+			};
+			struct t_sndhold { // send buffer of a closed fd, referenced by the send operations in flight
+				int kfd;
+				int usends; // send operations in flight
+				ec::io_buffer<> buf;
+			};
+			udpbatch_ _udp; // recvmmsg/sendmmsg in batches
+
+		protected:
+			/**
+			 * @brief before disconnect call
+			 * @param kfd keyfd
+			*/
+			virtual void onDisconnect(int kfd) = 0;
+
+			/**
+			 * @brief after disconnect call
+			 * @param kfd keyfd
+			*/
+			virtual void onDisconnected(int kfd) = 0;
+
+			/**
+			 * @brief received data
+			 * @param kfd keyfd
+			 * @param pdata Received data
+			 * @param size  Received data size
+			 * @return 0:OK; -1:error
+			*/
+			virtual int onReceived(int kfd, const void* pdata, size_t size) = 0;
+
+			/**
+			 * @brief received data into the parse buffer of session, used when _rbufrecv and session::rbufrecv()
+			 * @param kfd keyfd
+			 * @param size  Received data size, already appended to _rbuf
+			 * @return 0:OK; -1:error
+			*/
+			virtual int onReceivedRbuf(int kfd, size_t size) {
+				return -1;
+			}
+
+			/**
+			 * @brief received UDP data
+			 * @param kfd keyfd
+			 * @param pdata Received data
+			 * @param size  Received data size
+			 * @param addrfrom peer address
+			 * @param size of peer address
+			 * @return 0:OK; -1:error
+			*/
+			virtual int onReceivedFrom(int kfd, const void* pdata, size_t size, const struct sockaddr* addrfrom, int addrlen) {
+				return 0;
+			}
+
+			/**
+			 * @brief TCP Accept
+			 * @param kfd keyfd
+			 * @param sip peer ip
+			 * @param port peer port
+			 * @param kfd_listen keyfd of listened
+			*/
+			virtual void onAccept(int kfd, const char* sip, uint16_t port, int kfd_listen) = 0;
+
+			/**
+			 * @brief size can receive ,use for flowctrl
+			 * @param pss
+			 * @return >0 size can receive;  0: pause read
+			*/
+			virtual size_t  sizeCanRecv(psession pss) {
+				return EC_AIO_READONCE_SIZE;
+			};
+
+			/**
+			* @brief TCP asyn connect out success
+			* @param kfd keyfd
+			* @remark will call onDisconnect and onDisconnected if failed.
+			*/
+			virtual void onTcpOutConnected(int kfd) {
+			}
+
+			/**
+			 * @brief get the session of kfd
+			 * @param kfd keyfd
+			 * @return nullptr or psession
+			*/
+			virtual psession getSession(int kfd) = 0;
+
+			virtual void onSendtoFailed(int kfd, const struct sockaddr* paddr, int addrlen, const void* pdata, size_t datasize, int errcode) {};
+			virtual void onSendCompleted(int kfd, size_t size) {};
+
+			/**
+			 * @brief wakeup by other thread call wakeup(), run in the io_uring thread.
+			*/
+			virtual void onWakeup() {};
+		protected:
+			inline int setsendbuf(int fd, int n)
+			{
+				return _net.setsendbuf(fd, n);
+			}
+
+			inline int setrecvbuf(int fd, int n)
+			{
+				return _net.setrecvbuf(fd, n);
+			}
+
+			inline int connect_asyn(const struct sockaddr* addr, socklen_t addrlen) {
+				return _net.connect_asyn(addr, addrlen);
+			}
+
+			/**
+			 * @brief shutdown and close a kfd
+			 * @param kfd  keyfd
+			 * @return
+			*/
+			int close_(int kfd) //shutdown and close kfd
+			{
+				int ftype = _net.getfdtype(kfd);
+				if (ftype < 0)
+					return -1;
+				_plog->add(CLOG_DEFAULT_DBG, "close_ fd(%d), fdtype = %d", kfd, ftype);
+				_net.close_(kfd);
+				return 0;
+			}
+
+			/**
+			 * @brief wait tcp connect out completed, the same name as serverepoll_ for netserver
+			 * @param kfd keyfd from connect_asyn()
+			 * @return 0:ok; -1:error and kfd closed
+			*/
+			int epoll_add_tcpout(int kfd)
+			{
+				if (!armpoll(kfd, POLLOUT, uop_connect, false)) {
+					_plog->add(CLOG_DEFAULT_ERR, "fd(%d) io_uring poll connect failed.", kfd);
+					_net.close_(kfd);
+					return -1;
+				}
+				return 0;
+			}
+
+			inline bool setkeepalive(int fd, bool bfast = false)
+			{
+				return _net.setkeepalive(fd, bfast) >= 0;
+			}
+
+			inline bool tcpnodelay(int fd)
+			{
+				return _net.tcpnodelay(fd) >= 0;
+			}
+		public:
+			serveruring_(ec::ilog* plog) : _plog(plog), _fdwakeup(-1), _sysfdwakeup(-1), _rbufrecv(false), _lastwaiterr(0)
+			{
+			}
+			virtual ~serveruring_() {
+			}
+			inline void SetFdFile(const char* sfile) {
+				_net.SetFdFile(sfile);
+			}
+
+			/**
+			 * @brief set fd space for multi-reactor, call before open()
+			 * @param nid reactor id
+			 * @param nspaces number of reactors
+			*/
+			inline void setfdspace(int nid, int nspaces) {
+				_net.setfdspace(nid, nspaces);
+			}
+
+			/**
+			 * @brief wakeup io_uring_enter, thread safe. will call onWakeup() in the io_uring thread.
+			*/
+			void wakeup()
+			{
+				if (_sysfdwakeup >= 0)
+					eventfd_write(_sysfdwakeup, 1);
+			}
+
+			//create io_uring, return 0:ok; -1:error
+			int open()
+			{
+				if (_ring.isopen())
+					return 0;
+				if (_ring.open(EC_AIO_URING_ENTRIES, EC_AIO_URING_BUFS, EC_AIO_READONCE_SIZE, 1) < 0) {
+					_plog->add(CLOG_DEFAULT_ERR, "io_uring create failed, need Linux 6.0+. error = %d", errno);
+					return -1;
+				}
+				_fdwakeup = _net.create_eventfd_();
+				if (_fdwakeup >= 0) {
+					if (!armpoll(_fdwakeup, POLLIN, uop_pollin, true)) {
+						_plog->add(CLOG_DEFAULT_ERR, "io_uring poll eventfd failed.");
+						_net.close_(_fdwakeup);
+						_fdwakeup = -1;
+					}
+					else
+						_sysfdwakeup = _net.getsysfd(_fdwakeup);
+				}
+				_plog->add(CLOG_DEFAULT_MSG, "io_uring create success. %s", _ring.islegacybuf() ? "use IORING_OP_PROVIDE_BUFFERS" : "use provided buffer ring");
+				return 0;
+			}
+
+			/**
+			 * @brief 关闭所有连接和io_uring
+			 * @remark 用于退出时调用，不会通知应用层连接断开，应用层需自己释放和连接相关的资源。
+			*/
+			void close()
+			{
+				_ring.close(); // cancel all operations in flight
+				ec::vector<int> fds;
+				fds.reserve(1024);
+				_net.getall(fds);
+				for (auto& i : fds) {
+					_plog->add(CLOG_DEFAULT_DBG, "close fd(%d), fdtype = %d @serveruring_::close", i, _net.getfdtype(i));
+					_net.close_(i);
+				}
+				_fdwakeup = -1;
+				_sysfdwakeup = -1;
+				_rdpendings.clear();
+				_sndwaits.clear();
+				_sndholds.clear();
+			}
+
+			/**
+			 * @brief tcp listen
+			 * @param port port
+			 * @param sip  ipv4 or ipv6, nullptr or empty is ipv4 0.0.0.0
+			 * @param reuseport set SO_REUSEPORT, used by multi-reactor, each reactor listen the same port.
+			 * @return virtual fd; -1:failed
+			*/
+			int tcplisten(uint16_t port, const char* sip = nullptr, int ipv6only = 0, int reuseport = 0)
+			{
+				ec::net::socketaddr netaddr;
+				if (netaddr.set(port, sip) < 0)
+					return -1;
+				int addrlen = 0;
+				struct sockaddr* paddr = netaddr.getsockaddr(&addrlen);
+				if (!paddr)
+					return -1;
+				int fdl = _net.bind_listen(paddr, addrlen, ipv6only, reuseport);
+				if (fdl < 0) {
+					_plog->add(CLOG_DEFAULT_ERR, "bind listen tcp://%s:%u failed.", netaddr.viewip(), port);
+					return -1;
+				}
+				_plog->add(CLOG_DEFAULT_MSG, "fd(%d) bind listen tcp://%s:%u success.", fdl, netaddr.viewip(), port);
+				if (!armaccept(fdl)) {
+					_plog->add(CLOG_DEFAULT_ERR, "io_uring accept failed.");
+					_net.close_(fdl);
+					return -1;
+				}
+				return fdl;
+			}
+
+			int udplisten(uint16_t port, const char* sip = nullptr, int ipv6only = 0) // return udp server fd, -1 error
+			{
+				ec::net::socketaddr netaddr;
+				if (netaddr.set(port, sip) < 0)
+					return -1;
+				int addrlen = 0;
+				struct sockaddr* paddr = netaddr.getsockaddr(&addrlen);
+				if (!paddr)
+					return -1;
+				int fdl = _net.create_udp(paddr, addrlen, ipv6only);
+
+				if (fdl < 0) {
+					_plog->add(CLOG_DEFAULT_ERR, "bind udp://%s:%u failed.", netaddr.viewip(), port);
+					return -1;
+				}
+				_plog->add(CLOG_DEFAULT_MSG, "fd(%d) bind udp://%s:%u success.", fdl, netaddr.viewip(), port);
+				if (!armpoll(fdl, POLLIN, uop_pollin, true)) {
+					_plog->add(CLOG_DEFAULT_ERR, "io_uring poll udp failed.");
+					_net.close_(fdl);
+					return -1;
+				}
+				return fdl;
+			}
+
+			void runtime_(int waitmsec)
+			{
+				if (!_ring.isopen())
+					return;
+				_ring.flushbufs();
+				if (!_rdpendings.empty()) // paused by the work of last loop, e.g. the messages in _rbuf or setreadpause()
+					dorecvflowctrl();
+				if (!_sndwaits.empty())
+					dosndwaits();
+				if (_ring.submit(waitmsec > 0 && _sndwaits.empty() ? waitmsec : -1) < 0) {
+					if (_lastwaiterr != errno)
+						_plog->add(CLOG_DEFAULT_ERR, "io_uring_enter failed. error = %d", errno);
+					_lastwaiterr = errno;
+				}
+				_ring.forcqes([this](const struct io_uring_cqe& cqe) {
+					oncqe(cqe);
+				});
+				_ring.flushbufs();
+				_ring.submit(-1);
+				if (!_sndwaits.empty()) { // the completions processed free the submission queue
+					dosndwaits();
+					_ring.submit(-1);
+				}
+			}
+
+			/**
+			 * @brief 设置可发送事件
+			 * @param kfd keyfd
+			*/
+			void sendtrigger(int kfd)
+			{
+				psession pss = getSession(kfd);
+				if (pss && sendlinks(pss) < 0)
+					closefd(kfd);
+			}
+
+			void udp_trigger(int kfd, bool bsend)
+			{
+				if (bsend && udp_sendto(kfd)) {
+					NETIO::t_fd* pfd = _net.getfdinfo(kfd);
+					if (pfd && !(pfd->uflags & uf_pollout) && armpoll(kfd, POLLOUT, uop_pollout, false)) {
+						pfd = _net.getfdinfo(kfd);
+						pfd->uflags |= uf_pollout;
+					}
+				}
+			}
+
+			/**
+			 * @brief 投递发送，不等待发送完成。
+			 * @param kfd keyfd
+			 * @return  >=0: post bytes;  -1:failed, close fd and call onDisconnected(kfd)
+			*/
+			int postsend(int kfd)
+			{
+				int ns = 0;
+				psession pss = getSession(kfd);
+				if (!pss)
+					return -1;
+				if ((ns = sendlinks(pss)) < 0) {
+					closefd(kfd);
+					return -1;
+				}
+				return ns;
+			}
+
+			/**
+			 * @brief 主动关闭连接，会产生onClosed调用
+			 * @param kfd keyfd
+			*/
+			void closefd(int kfd, bool bnotify = true)
+			{
+				if (bnotify)
+					onDisconnect(kfd);
+				NETIO::t_fd* pfd = _net.getfdinfo(kfd);
+				if (pfd) {
+					switch (pfd->fdtype) {
+					case NETIO::fd_listen:
+						cancel(kfd, uop_accept);
+						break;
+					case NETIO::fd_udp:
+						cancel(kfd, uop_pollin);
+						if (pfd->uflags & uf_pollout)
+							cancel(kfd, uop_pollout);
+						break;
+					case NETIO::fd_event:
+						cancel(kfd, uop_pollin);
+						break;
+					default: // submit pending sends before close, shutdown in close_() completes the operations in flight
+						if (pfd->uflags & uf_pollout)
+							cancel(kfd, uop_pollout);
+						if (pfd->usends || (pfd->uflags & uf_pollout))
+							_ring.submit(-1);
+						if (pfd->usends)
+							holdsndbuf(kfd, pfd->usends);
+						break;
+					}
+				}
+				_net.close_(kfd);
+				onDisconnected(kfd);
+			}
+
+			size_t size_fds()
+			{
+				return _net.size();
+			}
+
+			inline int getbufsize(int fd, int op)
+			{
+				return _net.getbufsize(fd, op);
+			}
+		protected:
+			ec::vector<t_sndhold> _sndholds; // send buffers of closed fds, freed at the last send completion
+		private:
+			ec::vector<int> _rdpendings; //paused sessions, stopped reading by sizeCanRecv() or _readpause
+			ec::vector<int> _rdchecks; //swap with _rdpendings in dorecvflowctrl
+			ec::vector<int> _sndwaits; // sessions wait submission queue entries for send
+			ec::vector<int> _sndchecks; //swap with _sndwaits in dosndwaits
+
+			static inline uint64_t userdata(int kfd, int op)
+			{
+				return ((uint64_t)(uint32_t)kfd << 8) | (uint32_t)op;
+			}
+
+			void setrdpending(psession pss)
+			{
+				if (!pss->_rdpending) {
+					pss->_rdpending = 1;
+					_rdpendings.push_back(pss->_fd);
+				}
+			}
+
+			void dorecvflowctrl()//接收流控, only check the paused sessions
+			{
+				psession pss;
+				NETIO::t_fd* pfd;
+				_rdchecks.swap(_rdpendings);
+				for (auto& i : _rdchecks) {
+					pss = getSession(i);
+					if (!pss || !pss->_rdpending) //closed or removed
+						continue;
+					if (pss->_readpause || !sizeCanRecv(pss)) {
+						_rdpendings.push_back(i);
+						continue;
+					}
+					pss->_rdpending = 0;
+					pfd = _net.getfdinfo(i);
+					if (pfd && !(pfd->uflags & uf_recv)) // re-armed at the end of recv if cancel in flight
+						armrecv(i);
+				}
+				_rdchecks.clear();
+			}
+
+			void resumeread(psession pss) // send buffer drained, resume the paused reading, no wait for the next loop
+			{
+				if (!pss->_rdpending || !pss->_sndbuf.empty() || pss->_readpause || !sizeCanRecv(pss))
+					return;
+				pss->_rdpending = 0; // removed from _rdpendings in dorecvflowctrl
+				NETIO::t_fd* pfd = _net.getfdinfo(pss->_fd);
+				if (pfd && !(pfd->uflags & uf_recv))
+					armrecv(pss->_fd);
+			}
+
+			void setsndwait(NETIO::t_fd* pfd)
+			{
+				if (!(pfd->uflags & uf_sndwait)) {
+					pfd->uflags |= uf_sndwait;
+					_sndwaits.push_back(pfd->kfd);
+				}
+			}
+
+			void dosndwaits() // submission queue was full at sendlinks, send again
+			{
+				psession pss;
+				NETIO::t_fd* pfd;
+				_sndchecks.swap(_sndwaits);
+				for (auto& i : _sndchecks) {
+					if (!(pfd = _net.getfdinfo(i))) //closed
+						continue;
+					pfd->uflags &= ~uf_sndwait;
+					if ((pss = getSession(i)) && sendlinks(pss) < 0)
+						closefd(i);
+				}
+				_sndchecks.clear();
+			}
+
+			/**
+			 * @brief closing fd with send operations in flight, move the send buffer of session to _sndholds.
+			 *  the session is deleted after close, the blocks will be freed at the last send completion.
+			*/
+			void holdsndbuf(int kfd, int usends)
+			{
+				psession pss = getSession(kfd);
+				if (!pss || pss->_sndbuf.empty())
+					return;
+				ec::blk_alloctor<>* palloc = pss->_sndbuf.allocator();
+				size_t zmax = pss->_sndbuf.sizemax();
+				_sndholds.push_back(t_sndhold{ kfd, usends, std::move(pss->_sndbuf) });
+				pss->_sndbuf = ec::io_buffer<>(zmax, palloc);
+			}
+
+			void onholdsend(int kfd)
+			{
+				for (auto it = _sndholds.begin(); it != _sndholds.end(); ++it) {
+					if (it->kfd == kfd) {
+						if (--it->usends <= 0)
+							_sndholds.erase(it);
+						return;
+					}
+				}
+			}
+
+			bool armaccept(int kfd)
+			{
+				int sysfd = _net.getsysfd(kfd);
+				struct io_uring_sqe* sqe;
+				if (sysfd < 0 || !(sqe = _ring.getsqe()))
+					return false;
+				sqe->opcode = IORING_OP_ACCEPT;
+				sqe->fd = sysfd;
+				sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+				sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+				sqe->user_data = userdata(kfd, uop_accept);
+				return true;
+			}
+
+			bool armrecv(int kfd)
+			{
+				NETIO::t_fd* pfd = _net.getfdinfo(kfd);
+				struct io_uring_sqe* sqe;
+				if (!pfd || !(sqe = _ring.getsqe()))
+					return false;
+				sqe->opcode = IORING_OP_RECV;
+				sqe->fd = pfd->sysfd;
+				sqe->ioprio = IORING_RECV_MULTISHOT;
+				sqe->flags = IOSQE_BUFFER_SELECT;
+				sqe->buf_group = (uint16_t)_ring.bgid();
+				sqe->user_data = userdata(kfd, uop_recv);
+				pfd->uflags = (pfd->uflags | uf_recv) & ~uf_cancel;
+				return true;
+			}
+
+			bool armpoll(int kfd, uint32_t events, int op, bool bmultishot)
+			{
+				int sysfd = _net.getsysfd(kfd);
+				struct io_uring_sqe* sqe;
+				if (sysfd < 0 || !(sqe = _ring.getsqe()))
+					return false;
+				sqe->opcode = IORING_OP_POLL_ADD;
+				sqe->fd = sysfd;
+				sqe->poll32_events = events;
+				sqe->len = bmultishot ? IORING_POLL_ADD_MULTI : 0;
+				sqe->user_data = userdata(kfd, op);
+				return true;
+			}
+
+			void cancel(int kfd, int op)
+			{
+				struct io_uring_sqe* sqe = _ring.getsqe();
+				if (!sqe)
+					return;
+				sqe->opcode = IORING_OP_ASYNC_CANCEL;
+				sqe->fd = -1;
+				sqe->addr = userdata(kfd, op);
+				sqe->user_data = userdata(kfd, uop_cancel);
+			}
+
+			/**
+			 * @brief submit linked send of the head blocks in _sndbuf if no send in flight
+			 * @param pss
+			 * @return bytes posted; -1:error
+			*/
+			int sendlinks(psession pss)
+			{
+				NETIO::t_fd* pfd = _net.getfdinfo(pss->_fd);
+				if (!pfd)
+					return -1;
+				if (pfd->usends || (pfd->uflags & uf_pollout) || pss->_status == EC_AIO_FD_CONNECTING
+					|| (pfd->fdtype != NETIO::fd_tcp && pfd->fdtype != NETIO::fd_tcpout))
+					return 0;
+				const void* pbufs[EC_AIO_URING_SENDLINKS];
+				size_t lens[EC_AIO_URING_SENDLINKS];
+				int i, nf = 0, n = pss->_sndbuf.peek(pbufs, lens, EC_AIO_URING_SENDLINKS);
+				if (!n && pss->hasSendJob()) { // continue the send job, e.g. http download big file
+					int fd = pss->_fd, ns;
+					while ((ns = pss->sendfilejob(pfd->sysfd)) > 0) // zero-copy, until system buffer full or job completed
+						nf += ns;
+					if (nf) {
+						pss->_allsend += nf;
+						pss->_bpsSnd.add(ec::mstime(), nf);
+						onSendCompleted(fd, nf);
+					}
+					if (ns < 0) {
+						_plog->add(CLOG_DEFAULT_ERR, "fd(%d) sendfilejob failed, syserr %d", fd, errno);
+						return -1;
+					}
+					if (!(pss = getSession(fd)) || !pss->onSendCompleted())
+						return -1;
+					if (!(pfd = _net.getfdinfo(fd)))
+						return -1;
+					n = pss->_sndbuf.peek(pbufs, lens, EC_AIO_URING_SENDLINKS);
+					if (!n && pss->hasSendJob()) { // socket buffer full, wait POLLOUT
+						if (armpoll(fd, POLLOUT, uop_pollout, false))
+							pfd->uflags |= uf_pollout;
+						else
+							setsndwait(pfd);
+						return nf;
+					}
+				}
+				if (!n)
+					return nf;
+				if (_ring.sqfree() < (unsigned)n) {
+					_ring.submit(-1);
+					if (_ring.sqfree() < (unsigned)n && !(n = (int)_ring.sqfree())) { // send again in dosndwaits
+						setsndwait(pfd);
+						return nf;
+					}
+				}
+				int nsnd = nf;
+				struct io_uring_sqe* sqe;
+				for (i = 0; i < n; i++) {
+					sqe = _ring.getsqe();
+					sqe->opcode = IORING_OP_SEND;
+					sqe->fd = pfd->sysfd;
+					sqe->addr = (uint64_t)(uintptr_t)pbufs[i];
+					sqe->len = (uint32_t)lens[i];
+					sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+					sqe->flags = i + 1 < n ? IOSQE_IO_LINK : 0;
+					sqe->user_data = userdata(pss->_fd, uop_send);
+					nsnd += (int)lens[i];
+				}
+				pfd->usends = n;
+				return nsnd;
+			}
+
+			void oncqe(const struct io_uring_cqe& cqe)
+			{
+				int kfd = (int)(uint32_t)(cqe.user_data >> 8);
+				switch ((int)(cqe.user_data & 0xFF)) {
+				case uop_recv:
+					onrecv(kfd, cqe);
+					break;
+				case uop_send:
+					onsend(kfd, cqe.res);
+					break;
+				case uop_accept:
+					onaccept(kfd, cqe);
+					break;
+				case uop_pollin:
+					onpollin(kfd, cqe);
+					break;
+				case uop_pollout:
+					onpollout(kfd);
+					break;
+				case uop_connect:
+					onconnect(kfd, cqe.res);
+					break;
+				default:
+					break;
+				}
+			}
+
+			void onrecv(int kfd, const struct io_uring_cqe& cqe)
+			{
+				char* pbuf = nullptr;
+				unsigned bid = 0;
+				if (cqe.flags & IORING_CQE_F_BUFFER) {
+					bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+					pbuf = _ring.bufaddr(bid);
+				}
+				NETIO::t_fd* pfd = _net.getfdinfo(kfd);
+				if (!pfd) { // closed
+					if (pbuf)
+						_ring.addbuf(bid);
+					return;
+				}
+				if (!(cqe.flags & IORING_CQE_F_MORE))
+					pfd->uflags &= ~(uf_recv | uf_cancel);
+				if (cqe.res > 0 && pbuf) {
+#ifdef _DEBUG
+					_plog->add(CLOG_DEFAULT_ALL, "fd(%d) received %d bytes", kfd, cqe.res);
+#endif
+					int nr = -1;
+					psession pss = _rbufrecv ? getSession(kfd) : nullptr;
+					if (pss && pss->rbufrecv()) {
+						if (pss->_rbuf.append(pbuf, cqe.res) >= 0)
+							nr = onReceivedRbuf(kfd, cqe.res);
+					}
+					else
+						nr = onReceived(kfd, pbuf, cqe.res); // no copy to _recvtmp
+					_ring.addbuf(bid);
+					if (nr < 0) {
+						closefd(kfd);
+						return;
+					}
+				}
+				else {
+					if (pbuf)
+						_ring.addbuf(bid);
+					if (!cqe.res || (cqe.res < 0 && -ENOBUFS != cqe.res && -ECANCELED != cqe.res)) {
+						_plog->add(CLOG_DEFAULT_DBG, "fd(%d) recv return %d", kfd, cqe.res);
+						closefd(kfd);
+						return;
+					}
+				}
+				psession pss = getSession(kfd);
+				if (!pss || !(pfd = _net.getfdinfo(kfd)))
+					return;
+				if (pss->_readpause || !sizeCanRecv(pss) || -ENOBUFS == cqe.res) { // ENOBUFS re-arm in dorecvflowctrl after buffers provided
+					if ((pfd->uflags & uf_recv) && !(pfd->uflags & uf_cancel)) {
+						cancel(kfd, uop_recv);
+						pfd->uflags |= uf_cancel;
+					}
+					setrdpending(pss);
+				}
+				else if (!(pfd->uflags & uf_recv))
+					armrecv(kfd);
+			}
+
+			void onsend(int kfd, int res)
+			{
+				NETIO::t_fd* pfd = _net.getfdinfo(kfd);
+				if (!pfd) { // closed
+					onholdsend(kfd);
+					return;
+				}
+				if (pfd->usends > 0)
+					--pfd->usends;
+				psession pss = getSession(kfd);
+				if (!pss)
+					return;
+				if (res > 0) {
+#ifdef _DEBUG
+					_plog->add(CLOG_DEFAULT_ALL, "fd(%d) send %d bytes", kfd, res);
+#endif
+					pss->_sndbuf.freesize(res);
+					pss->_allsend += res;
+					pss->_bpsSnd.add(ec::mstime(), res);
+					onSendCompleted(kfd, res);
+				}
+				else if (res < 0 && -ECANCELED != res) { // ECANCELED: link broken by a short send before
+					_plog->add(CLOG_DEFAULT_DBG, "fd(%d) send failed. error %d", kfd, -res);
+					closefd(kfd);
+					return;
+				}
+				if (!(pfd = _net.getfdinfo(kfd)) || pfd->usends || !(pss = getSession(kfd)))
+					return;
+				if (pss->_sndbuf.empty() && !pss->onSendCompleted()) {
+					closefd(kfd);
+					return;
+				}
+				if (sendlinks(pss) < 0) {
+					closefd(kfd);
+					return;
+				}
+				resumeread(pss);
+			}
+
+			void onaccept(int kfdlisten, const struct io_uring_cqe& cqe)
+			{
+				if (!(cqe.flags & IORING_CQE_F_MORE) && _net.getfdtype(kfdlisten) == NETIO::fd_listen) {
+					if (!armaccept(kfdlisten))
+						_plog->add(CLOG_DEFAULT_ERR, "listen fd(%d) io_uring accept failed.", kfdlisten);
+				}
+				if (cqe.res < 0) {
+					if (-ECANCELED != cqe.res)
+						_plog->add(CLOG_DEFAULT_ERR, "accept failed. listen fd = %d, error = %d", kfdlisten, -cqe.res);
+					return;
+				}
+				int fdc = _net.attach_tcp_(cqe.res);
+				if (fdc < 0) {
+					::close(cqe.res);
+					_plog->add(CLOG_DEFAULT_ERR, "accept failed, fd table full. listen fd = %d", kfdlisten);
+					return;
+				}
+				ec::net::socketaddr clientaddr;
+				socklen_t* paddrlen = nullptr;
+				struct sockaddr* paddr = clientaddr.getbuffer(&paddrlen);
+				getpeername(cqe.res, paddr, paddrlen);
+				uint16_t uport = 0;
+				char sip[48] = { 0 };
+				clientaddr.get(uport, sip, sizeof(sip));
+				_plog->add(CLOG_DEFAULT_INF, "fd(%d) accept from %s:%u at listen fd(%d)",
+					fdc, clientaddr.viewip(), uport, kfdlisten);
+				onAccept(fdc, sip, uport, kfdlisten);
+				if (getSession(fdc))
+					armrecv(fdc);
+			}
+
+			void onpollin(int kfd, const struct io_uring_cqe& cqe)
+			{
+				int nfdtype = _net.getfdtype(kfd);
+				if (nfdtype < 0 || -ECANCELED == cqe.res)
+					return;
+				if (nfdtype == NETIO::fd_event)
+					_net.read_eventfd_(kfd);
+				else if (nfdtype == NETIO::fd_udp) {
+					if (cqe.res > 0 && (cqe.res & (POLLERR | POLLHUP))) {
+						_plog->add(CLOG_DEFAULT_DBG, "udp fd(%d)  error events %08XH", kfd, cqe.res);
+						closefd(kfd);
+						return;
+					}
+					onudpin(kfd);
+				}
+				if (_net.getfdtype(kfd) >= 0 && !(cqe.flags & IORING_CQE_F_MORE))
+					armpoll(kfd, POLLIN, uop_pollin, true);
+				if (nfdtype == NETIO::fd_event)
+					onWakeup();
+			}
+
+			void onpollout(int kfd)
+			{
+				NETIO::t_fd* pfd = _net.getfdinfo(kfd);
+				if (!pfd)
+					return;
+				pfd->uflags &= ~uf_pollout;
+				if (pfd->fdtype == NETIO::fd_udp) {
+					udp_trigger(kfd, true);
+					return;
+				}
+				psession pss = getSession(kfd);
+				if (pss && sendlinks(pss) < 0)
+					closefd(kfd);
+			}
+
+			void onconnect(int kfd, int res)
+			{
+				psession pss = getSession(kfd);
+				if (!pss || _net.getfdtype(kfd) != NETIO::fd_tcpout)
+					return;
+				int serr = 0;
+				socklen_t serrlen = sizeof(serr);
+				getsockopt(_net.getsysfd(kfd), SOL_SOCKET, SO_ERROR, (void*)&serr, &serrlen);
+				if (res < 0 || serr) {
+					closefd(kfd);
+					return;
+				}
+				pss->_status = EC_AIO_FD_CONNECTED;
+				onTcpOutConnected(kfd);
+				if (!(pss = getSession(kfd)))
+					return;
+				armrecv(kfd);
+				if (sendlinks(pss) < 0)
+					closefd(kfd);
+			}
+
+			void onudpin(int kfd)
+			{
+				_udp.recvfrom(_net, kfd, _plog, [&](const void* pdata, size_t size, const struct sockaddr* addrfrom, int addrlen) {
+					return onReceivedFrom(kfd, pdata, size, addrfrom, addrlen);
+				});
+			}
+
+			/**
+			 * @brief send udp frames in batches
+			 * @return true: has frames wait POLLOUT
+			*/
+			bool udp_sendto(int kfd)
+			{
+				psession pss = getSession(kfd);
+				if (!pss)
+					return false;
+				udb_buffer_* pfrms = pss->getudpsndbuffer();
+				if (!pfrms || pfrms->empty())
+					return false;
+				int nbytes = 0;
+				int numsnd = _udp.sendto(_net, kfd, pfrms, _plog, nbytes, [&](udp_frm_& frm, int errcode) {
+					onSendtoFailed(kfd, frm.getnetaddr(), frm.netaddrlen(), frm.data(), frm.size(), errcode);
+				});
+				if (numsnd) {
+					pss->onUdpSendCount(numsnd, nbytes);
+					onSendCompleted(kfd, nbytes);
+				}
+				return !pfrms->empty();
+			}
+		};
+	}//namespace aio
+}//namespace ec
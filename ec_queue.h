@@ -4,10 +4,18 @@
 \author jiangyong
 \email  kipway@outlook.com
 \update 2022.10.9
+\update 2026.10.17 add spsc_queue and mpsc_queue, bounded lock-free ring with batch push/pop
+\update 2026.10.17 add forward iterator, used to batch the front elements
 
 queue
 	 FIFO context
 
+spsc_queue
+	bounded lock-free ring, single producer single consumer
+
+mpsc_queue
+	bounded lock-free ring, multi producer single consumer
+
 eclib 3.0 Copyright (c) 2017-2022, kipway
 source repository : https://github.com/kipway
 
@@ -15,7 +23,16 @@ Licensed under the Apache License, Version 2.0 (the "License");
 You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
 */
 #pragma once
+#include <stdint.h>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include "ec_alloctor.h"
+
+#ifndef EC_CACHELINE_SIZE
+#define EC_CACHELINE_SIZE 64 // pad the producer and consumer positions of the lock-free queues to separate cache lines
+#endif
 namespace ec
 {
 	template<class _Ty>
@@ -50,6 +67,29 @@ namespace ec
 		t_node* _ptail;
 		size_type _size;
 	public:
+		class iterator
+		{
+			t_node* _pnode;
+		public:
+			iterator(t_node* pnode) : _pnode(pnode) {
+			}
+			inline reference operator*() {
+				return _pnode->value;
+			}
+			inline value_type* operator->() {
+				return &_pnode->value;
+			}
+			inline iterator& operator++() {
+				_pnode = _pnode->pNext;
+				return *this;
+			}
+			inline bool operator==(const iterator& v) const {
+				return _pnode == v._pnode;
+			}
+			inline bool operator!=(const iterator& v) const {
+				return _pnode != v._pnode;
+			}
+		};
 		queue() :_phead(nullptr), _ptail(nullptr), _size(0) {
 		}
 		~queue() {
@@ -65,6 +105,14 @@ namespace ec
 		{
 			return _size;
 		}
+		inline iterator begin()
+		{
+			return iterator(_phead);
+		}
+		inline iterator end()
+		{
+			return iterator(nullptr);
+		}
 		inline reference& front()
 		{
 			return _phead->value;
@@ -163,4 +211,355 @@ namespace ec
 			++_size;
 		}
 	};
+
+	/*!
+	\brief bounded lock-free ring, single producer single consumer.
+	capacity is rounded up to power of 2. push and pop never block and never allocate, push return false when full.
+	each side caches the position of the other side, only reload it from the shared atomic when the cache says full/empty.
+	*/
+	template<class _Ty>
+	class spsc_queue
+	{
+	public:
+		using value_type = _Ty;
+		using size_type = size_t;
+	protected:
+		using slot_ = typename std::aligned_storage<sizeof(_Ty), alignof(_Ty)>::type;
+		slot_* _pslots;
+		size_t _mask;
+		char _pad0[EC_CACHELINE_SIZE];
+		std::atomic<size_t> _tail; // next write position, write by producer
+		size_t _headcache; // producer's copy of _head
+		char _pad1[EC_CACHELINE_SIZE];
+		std::atomic<size_t> _head; // next read position, write by consumer
+		size_t _tailcache; // consumer's copy of _tail
+		char _pad2[EC_CACHELINE_SIZE];
+		std::atomic<int> _signaled;
+		char _pad3[EC_CACHELINE_SIZE];
+
+		inline _Ty* at_(size_t pos)
+		{
+			return reinterpret_cast<_Ty*>(&_pslots[pos & _mask]);
+		}
+	public:
+		spsc_queue(const spsc_queue&) = delete;
+		spsc_queue& operator = (const spsc_queue&) = delete;
+
+		spsc_queue(size_t capacity) : _pslots(nullptr), _mask(0), _tail(0), _headcache(0), _head(0), _tailcache(0), _signaled(0)
+		{
+			size_t n = 2;
+			while (n < capacity)
+				n <<= 1;
+			_pslots = (slot_*)ec_malloc(n * sizeof(slot_));
+			if (_pslots)
+				_mask = n - 1;
+		}
+		~spsc_queue()
+		{
+			if (!_pslots)
+				return;
+			size_t t = _tail.load(std::memory_order_relaxed);
+			for (size_t h = _head.load(std::memory_order_relaxed); h != t; ++h)
+				at_(h)->~_Ty();
+			ec_free(_pslots);
+		}
+		inline size_t capacity() const
+		{
+			return _pslots ? _mask + 1 : 0;
+		}
+		inline size_t size() const // approximate when called by other threads
+		{
+			return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+		}
+		inline bool empty() const
+		{
+			return !size();
+		}
+
+		/*!
+		\brief construct one element at tail, producer only
+		\return false if full
+		*/
+		template <typename... Args>
+		bool push(Args&&... args)
+		{
+			if (!_pslots)
+				return false;
+			size_t t = _tail.load(std::memory_order_relaxed);
+			if (t - _headcache > _mask) {
+				_headcache = _head.load(std::memory_order_acquire);
+				if (t - _headcache > _mask)
+					return false;
+			}
+			new (at_(t)) _Ty(std::forward<Args>(args)...);
+			_tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		/*!
+		\brief move n elements to tail and publish once, producer only
+		\return number of elements pushed, the rest of pv are not touched
+		*/
+		size_t push_n(_Ty* pv, size_t n)
+		{
+			if (!_pslots)
+				return 0;
+			size_t t = _tail.load(std::memory_order_relaxed);
+			size_t nfree = _mask + 1 - (t - _headcache);
+			if (nfree < n) {
+				_headcache = _head.load(std::memory_order_acquire);
+				nfree = _mask + 1 - (t - _headcache);
+			}
+			if (n > nfree)
+				n = nfree;
+			for (size_t i = 0; i < n; i++)
+				new (at_(t + i)) _Ty(std::move(pv[i]));
+			if (n)
+				_tail.store(t + n, std::memory_order_release);
+			return n;
+		}
+
+		/*!
+		\brief move out one element from head, consumer only
+		\return false if empty
+		*/
+		bool pop(_Ty& v)
+		{
+			size_t h = _head.load(std::memory_order_relaxed);
+			if (h == _tailcache) {
+				_tailcache = _tail.load(std::memory_order_acquire);
+				if (h == _tailcache)
+					return false;
+			}
+			_Ty* p = at_(h);
+			v = std::move(*p);
+			p->~_Ty();
+			_head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+		/*!
+		\brief call fun(_Ty&) for up to maxn elements at head, then release them with one store, consumer only
+		\return number of elements consumed
+		*/
+		template <class _Fun>
+		size_t pop_n(_Fun&& fun, size_t maxn = SIZE_MAX)
+		{
+			size_t h = _head.load(std::memory_order_relaxed);
+			if (_tailcache - h < maxn)
+				_tailcache = _tail.load(std::memory_order_acquire);
+			size_t n = _tailcache - h;
+			if (n > maxn)
+				n = maxn;
+			for (size_t i = 0; i < n; i++) {
+				_Ty* p = at_(h + i);
+				fun(*p);
+				p->~_Ty();
+			}
+			if (n)
+				_head.store(h + n, std::memory_order_release);
+			return n;
+		}
+
+		/*!
+		\brief producer call after push, return true if the consumer need to be woken up (eventfd_write etc.),
+		only the first signal after consumer's unsignal() return true.
+		*/
+		inline bool signal()
+		{
+			return !_signaled.exchange(1, std::memory_order_seq_cst);
+		}
+
+		/*!
+		\brief consumer call before draining, elements pushed after this will signal again.
+		*/
+		inline void unsignal()
+		{
+			_signaled.exchange(0, std::memory_order_seq_cst);
+		}
+	};
+
+	/*!
+	\brief bounded lock-free ring, multi producer single consumer.
+	each slot has a sequence number (D.Vyukov bounded queue), producers claim slots by CAS on _tail,
+	the consumer owns _head and does not use CAS. capacity is rounded up to power of 2.
+	*/
+	template<class _Ty>
+	class mpsc_queue
+	{
+	public:
+		using value_type = _Ty;
+		using size_type = size_t;
+	protected:
+		struct t_slot {
+			std::atomic<size_t> seq; // == pos: free for pos; == pos + 1: ready for pos
+			typename std::aligned_storage<sizeof(_Ty), alignof(_Ty)>::type val;
+		};
+		t_slot* _pslots;
+		size_t _mask;
+		char _pad0[EC_CACHELINE_SIZE];
+		std::atomic<size_t> _tail; // next claim position, CAS by producers
+		char _pad1[EC_CACHELINE_SIZE];
+		std::atomic<size_t> _head; // next read position, write by consumer
+		char _pad2[EC_CACHELINE_SIZE];
+		std::atomic<int> _signaled;
+		char _pad3[EC_CACHELINE_SIZE];
+
+		inline t_slot* at_(size_t pos)
+		{
+			return &_pslots[pos & _mask];
+		}
+		inline _Ty* val_(t_slot* ps)
+		{
+			return reinterpret_cast<_Ty*>(&ps->val);
+		}
+
+		/*!
+		\brief claim n continuous slots
+		\return false if not enough free slots
+		*/
+		bool claim_(size_t n, size_t& pos)
+		{
+			if (!_pslots || !n || n > _mask + 1)
+				return false;
+			pos = _tail.load(std::memory_order_relaxed);
+			for (;;) {
+				size_t seq = at_(pos + n - 1)->seq.load(std::memory_order_acquire); // slots are freed in order, the last free means all free
+				intptr_t dif = (intptr_t)seq - (intptr_t)(pos + n - 1);
+				if (!dif) {
+					if (_tail.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+						return true;
+				}
+				else if (dif < 0)
+					return false;
+				else
+					pos = _tail.load(std::memory_order_relaxed);
+			}
+		}
+	public:
+		mpsc_queue(const mpsc_queue&) = delete;
+		mpsc_queue& operator = (const mpsc_queue&) = delete;
+
+		mpsc_queue(size_t capacity) : _pslots(nullptr), _mask(0), _tail(0), _head(0), _signaled(0)
+		{
+			size_t n = 2;
+			while (n < capacity)
+				n <<= 1;
+			_pslots = (t_slot*)ec_malloc(n * sizeof(t_slot));
+			if (!_pslots)
+				return;
+			for (size_t i = 0; i < n; i++)
+				new (&_pslots[i].seq) std::atomic<size_t>(i);
+			_mask = n - 1;
+		}
+		~mpsc_queue()
+		{
+			if (!_pslots)
+				return;
+			pop_n([](_Ty&) {});
+			ec_free(_pslots);
+		}
+		inline size_t capacity() const
+		{
+			return _pslots ? _mask + 1 : 0;
+		}
+		inline size_t size() const // approximate, include claimed but not yet published
+		{
+			return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+		}
+		inline bool empty() const
+		{
+			return !size();
+		}
+
+		/*!
+		\brief construct one element at tail, any thread
+		\return false if full
+		*/
+		template <typename... Args>
+		bool push(Args&&... args)
+		{
+			size_t pos;
+			if (!claim_(1, pos))
+				return false;
+			t_slot* ps = at_(pos);
+			new (val_(ps)) _Ty(std::forward<Args>(args)...);
+			ps->seq.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		/*!
+		\brief move n elements to tail with one CAS, all or nothing, any thread
+		\return false if not enough free slots
+		*/
+		bool push_n(_Ty* pv, size_t n)
+		{
+			size_t pos;
+			if (!claim_(n, pos))
+				return false;
+			for (size_t i = 0; i < n; i++) {
+				t_slot* ps = at_(pos + i);
+				new (val_(ps)) _Ty(std::move(pv[i]));
+				ps->seq.store(pos + i + 1, std::memory_order_release);
+			}
+			return true;
+		}
+
+		/*!
+		\brief move out one element from head, consumer only
+		\return false if empty or the head element is not yet published
+		*/
+		bool pop(_Ty& v)
+		{
+			size_t h = _head.load(std::memory_order_relaxed);
+			t_slot* ps = at_(h);
+			if (ps->seq.load(std::memory_order_acquire) != h + 1)
+				return false;
+			v = std::move(*val_(ps));
+			val_(ps)->~_Ty();
+			ps->seq.store(h + _mask + 1, std::memory_order_release);
+			_head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+		/*!
+		\brief call fun(_Ty&) for up to maxn published elements at head, consumer only.
+		stop at the first slot claimed but not yet published, keep the FIFO order.
+		\return number of elements consumed
+		*/
+		template <class _Fun>
+		size_t pop_n(_Fun&& fun, size_t maxn = SIZE_MAX)
+		{
+			size_t h = _head.load(std::memory_order_relaxed), n = 0;
+			while (n < maxn) {
+				t_slot* ps = at_(h + n);
+				if (ps->seq.load(std::memory_order_acquire) != h + n + 1)
+					break;
+				fun(*val_(ps));
+				val_(ps)->~_Ty();
+				ps->seq.store(h + n + _mask + 1, std::memory_order_release);
+				++n;
+			}
+			if (n)
+				_head.store(h + n, std::memory_order_release);
+			return n;
+		}
+
+		/*!
+		\brief producer call after push, return true if the consumer need to be woken up (eventfd_write etc.),
+		only the first signal after consumer's unsignal() return true.
+		*/
+		inline bool signal()
+		{
+			return !_signaled.exchange(1, std::memory_order_seq_cst);
+		}
+
+		/*!
+		\brief consumer call before draining, elements pushed after this will signal again.
+		*/
+		inline void unsignal()
+		{
+			_signaled.exchange(0, std::memory_order_seq_cst);
+		}
+	};
 }// namespace ec
@@ -3,6 +3,8 @@
 \author	jiangyong
 \email  kipway@outlook.com
 \update 
+2026.10.17 string_ store short string inline (SSO), add strview non-owning string
+2026.10.17 add arena_stralloctor, ec::astring and ec::abytes use the current ec::arena
 2023.8.10 add nul end in debug
 2023.6.26 Optimize ec::string_::append() compatibility 
 2023.5.25 add fixstring_
@@ -24,6 +26,12 @@ You may obtain a copy of the License at http://www.apache.org/licenses/LICENSE-2
 #include <ctype.h>
 #include <type_traits>
 #include "ec_alloctor.h"
+#include "ec_text.h"
+
+#ifndef EC_STRING_SSO_SIZE
+#define EC_STRING_SSO_SIZE 24 // inline buffer of ec::string_ include null, strings shorter than it not allocate. >= 8
+#endif
+
 namespace ec
 {
 	struct null_stralloctor { // use C malloc
@@ -56,6 +64,21 @@ namespace ec
 			ec_free(p);
 		}
 	};
+	struct arena_stralloctor { // use the current ec::arena in scope, ec_alloctor out of scope
+		void* realloc_(void* ptr, size_t size, size_t* poutsize)
+		{
+			if (ptr ? arena::inscope(ptr) : nullptr != arena::current())
+				return arena::cur_realloc_(ptr, size, poutsize);
+			return ec_string_alloctor().realloc_(ptr, size, poutsize);
+		}
+
+		inline void free_(void* p) {
+			if (arena::inscope(p))
+				arena::cur_free_(p);
+			else
+				ec_free(p);
+		}
+	};
 	template<class _Alloctor = null_stralloctor,
 		typename size_type = uint32_t,
 		typename chart = char,
@@ -77,20 +100,48 @@ namespace ec
 		};
 		static const size_t npos = -1;
 	private:
-		pointer _pstr; // point to data
+		struct t_sso { // inline string, same layout as the heap block
+			t_h h;
+			chart buf[EC_STRING_SSO_SIZE];
+		};
+		pointer _pstr; // point to data, nullptr or _sso.buf or heap
+		t_sso _sso;
 	private:
+		inline bool isinline() const
+		{
+			return _pstr == _sso.buf;
+		}
 		pointer srealloc(size_t strsize)
 		{
 			if (strsize > max_size())
 				return nullptr;
-			pointer pold = _pstr ? _pstr - sizeof(t_h) : nullptr;
+			if (strsize < EC_STRING_SSO_SIZE) { // fits inline, also from a heap block
+				if (isinline())
+					return _sso.buf;
+				size_t zlen = ssize(_pstr);
+				if (zlen < EC_STRING_SSO_SIZE) {
+					if (zlen)
+						memcpy(_sso.buf, _pstr, zlen);
+					_sso.h.sizebuf = EC_STRING_SSO_SIZE;
+					_sso.h.sizedata = (size_type)zlen;
+					if (_pstr)
+						_Alloctor().free_(_pstr - sizeof(t_h));
+					return _sso.buf;
+				}
+			}
+			pointer pold = (_pstr && !isinline()) ? _pstr - sizeof(t_h) : nullptr;
 			size_t zr = strsize + sizeof(t_h) + 1;
 			pointer pstr = (pointer)_Alloctor().realloc_(pold, zr, &zr);
 			if (pstr) {
 				t_h* ph = (t_h*)pstr;
 				ph->sizebuf = (size_type)(zr - sizeof(t_h));
-				if (!pold)
+				if (!pold) {
 					ph->sizedata = 0;
+					if (_pstr) { // from inline
+						ph->sizedata = _sso.h.sizedata;
+						memcpy(pstr + sizeof(t_h), _sso.buf, _sso.h.sizedata);
+					}
+				}
 				pstr += sizeof(t_h);
 			}
 			return pstr;
@@ -98,10 +149,21 @@ namespace ec
 		void sfree(pointer& str)
 		{
 			if (str) {
-				_Alloctor().free_(str - sizeof(t_h));
+				if (str != _sso.buf)
+					_Alloctor().free_(str - sizeof(t_h));
 				str = nullptr;
 			}
 		}
+		void movefrom_(string_& str) // _pstr is empty
+		{
+			if (str.isinline()) {
+				memcpy(&_sso, &str._sso, sizeof(t_h) + str._sso.h.sizedata);
+				_pstr = _sso.buf;
+			}
+			else
+				_pstr = str._pstr;
+			str._pstr = nullptr;
+		}
 		bool recapacity(size_t strsize)
 		{
 			if (!strsize) {
@@ -165,23 +227,25 @@ namespace ec
 		~string_() {
 			sfree(_pstr);
 		}
-		string_(string_<_Alloctor, size_type>&& str) noexcept // move construct
+		string_(string_&& str) noexcept : _pstr(nullptr) // move construct
 		{
-			_pstr = str._pstr;
-			str._pstr = nullptr;
+			movefrom_(str);
 		}
-		string_& operator= (string_<_Alloctor, size_type>&& v) // for move
+		string_& operator= (string_&& v) // for move
 		{
+			if (&v == this)
+				return *this;
 			sfree(_pstr);
-			_pstr = v._pstr;
-			v._pstr = nullptr;
+			movefrom_(v);
 			return *this;
 		}
-		void swap(string_<_Alloctor, size_type>& str) //simulate move
+		void swap(string_& str) //simulate move
 		{
-			pointer stmp = _pstr;
-			_pstr = str._pstr;
-			str._pstr = stmp;
+			if (&str == this)
+				return;
+			string_ stmp(std::move(str));
+			str.movefrom_(*this);
+			movefrom_(stmp);
 		}
 		template<typename _Str, class = typename std::enable_if<std::is_class<_Str>::value>::type>
 		string_& operator= (const _Str& str)
@@ -353,12 +417,9 @@ namespace ec
 			}
 			return *this;
 		}
-		string_& assign(string_<_Alloctor, size_type>&& v) noexcept
+		string_& assign(string_&& v) noexcept
 		{
-			sfree(_pstr);
-			_pstr = v._pstr;
-			v._pstr = nullptr;
-			return *this;
+			return operator=(std::move(v));
 		}
 		inline string_& assign(const_pointer s, size_t n) noexcept
 		{
@@ -635,8 +696,166 @@ namespace ec
 		}
 	}; // string_
 
+	/*!
+	\brief non-owning const string with length, like std::string_view.
+	construct from const char*, ec::string_, std::string, ec::txt, http::ctxt and any class with data() and size(),
+	ec::string_ and std::string can construct from it. do not keep it after the source changed or destroyed.
+	*/
+	class strview
+	{
+	public:
+		using value_type = char;
+		using const_pointer = const char*;
+		using const_iterator = const char*;
+		static const size_t npos = -1;
+
+		const char* _str;
+		size_t _size;
+	public:
+		strview() : _str(nullptr), _size(0)
+		{
+		}
+		strview(const char* s) : _str(s), _size(s ? strlen(s) : 0)
+		{
+		}
+		strview(const void* s, size_t size) : _str((const char*)s), _size(size)
+		{
+		}
+		template<typename _Str, class = typename std::enable_if<std::is_class<_Str>::value>::type>
+		strview(const _Str& str) : _str((const char*)str.data()), _size(str.size())
+		{
+		}
+		inline operator txt() const
+		{
+			return txt(_str, _size);
+		}
+		inline const char* data() const noexcept
+		{
+			return _str;
+		}
+		inline size_t size() const noexcept
+		{
+			return _size;
+		}
+		inline size_t length() const noexcept
+		{
+			return _size;
+		}
+		inline bool empty() const noexcept
+		{
+			return !_size;
+		}
+		inline const_iterator begin() const noexcept
+		{
+			return _str;
+		}
+		inline const_iterator end() const noexcept
+		{
+			return _str + _size;
+		}
+		inline char operator[](size_t pos) const noexcept
+		{
+			return _str[pos];
+		}
+		inline char front() const noexcept
+		{
+			return _str[0];
+		}
+		inline char back() const noexcept
+		{
+			return _str[_size - 1];
+		}
+		inline void clear() noexcept
+		{
+			_str = nullptr;
+			_size = 0;
+		}
+		inline void remove_prefix(size_t n) noexcept
+		{
+			if (n > _size)
+				n = _size;
+			_str += n;
+			_size -= n;
+		}
+		inline void remove_suffix(size_t n) noexcept
+		{
+			_size -= n > _size ? _size : n;
+		}
+		strview substr(size_t pos, size_t n = npos) const noexcept
+		{
+			if (pos >= _size)
+				return strview();
+			if (n > _size - pos)
+				n = _size - pos;
+			return strview(_str + pos, n);
+		}
+		size_t find(char c, size_t pos = 0) const noexcept
+		{
+			if (pos >= _size)
+				return npos;
+			const char* p = (const char*)memchr(_str + pos, c, _size - pos);
+			return p ? p - _str : npos;
+		}
+		size_t find(const strview& s, size_t pos = 0) const noexcept
+		{
+			if (!s._size)
+				return pos <= _size ? pos : npos;
+			while (pos + s._size <= _size) {
+				const char* p = (const char*)memchr(_str + pos, s._str[0], _size - pos - s._size + 1);
+				if (!p)
+					return npos;
+				pos = p - _str;
+				if (!memcmp(p, s._str, s._size))
+					return pos;
+				++pos;
+			}
+			return npos;
+		}
+		int compare(const strview& s) const noexcept
+		{
+			int n = _size && s._size ? memcmp(_str, s._str, _size < s._size ? _size : s._size) : 0;
+			if (n)
+				return n;
+			return _size == s._size ? 0 : (_size < s._size ? -1 : 1);
+		}
+		inline bool eq(const strview& s) const noexcept
+		{
+			return _size == s._size && (!_size || !memcmp(_str, s._str, _size));
+		}
+		bool ieq(const strview& s) const noexcept // Case insensitive equal
+		{
+			if (_size != s._size)
+				return false;
+			for (size_t i = 0; i < _size; i++) {
+				if (_str[i] != s._str[i] && tolower(_str[i]) != tolower(s._str[i]))
+					return false;
+			}
+			return true;
+		}
+		inline bool starts_with(const strview& s) const noexcept
+		{
+			return _size >= s._size && (!s._size || !memcmp(_str, s._str, s._size));
+		}
+		inline bool ends_with(const strview& s) const noexcept
+		{
+			return _size >= s._size && (!s._size || !memcmp(_str + _size - s._size, s._str, s._size));
+		}
+	};
+
+	inline bool operator==(const strview& a, const strview& b) noexcept
+	{
+		return a.eq(b);
+	}
+
+	inline bool operator!=(const strview& a, const strview& b) noexcept
+	{
+		return !a.eq(b);
+	}
+
 	using string = string_<ec_string_alloctor>;
 	using bytes = string_<ec_string_alloctor, uint32_t, uint8_t>;
+	using astring = string_<arena_stralloctor>; // temporary string in ec::arena::scope
+	using abytes = string_<arena_stralloctor, uint32_t, uint8_t>;
 	
 	inline string to_string(int _Val)
 	{
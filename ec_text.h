@@ -2,6 +2,7 @@
 \file ec_text.h
 \author	jiangyong
 \email  kipway@outlook.com
+\update 2026.10.17 add data() and size(), interoperate with ec::strview and ec::string_
 \update 2022.12.5
 
 txt
@@ -34,6 +35,14 @@ namespace ec
 		txt(const char *s, size_t size) : _str(s), _size(size)
 		{
 		}
+		inline const char* data() const // for ec::strview and ec::string_
+		{
+			return _str;
+		}
+		inline size_t size() const
+		{
+			return _size;
+		}
 		inline void clear()
 		{
 			_str = nullptr;
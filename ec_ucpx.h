@@ -4,6 +4,7 @@
 实现一个基于udp多通道并行的可靠传输的封装，取名为ucpx;
 
 \author jiangyong
+\update 2026-10-17 _map和_mapcon使用flatmap, 大量连接时查找不退化
 \update 2023-7-28 修正阻断超时删除
 \update 2023-6-22 优化重发
 \update 2023-6-12 优化确认和重发
@@ -1140,8 +1141,8 @@ namespace ec {
 				}
 			};
 
-			ec::hashmap<uint32_t, PSOCKET, keq_psocket> _mapcon; //连接中表,ssid为客户端分配(低16位)
-			ec::hashmap<uint32_t, PSOCKET, keq_psocket> _map; //已连接表
+			ec::flatmap<uint32_t, PSOCKET, keq_psocket> _mapcon; //连接中表,ssid为客户端分配(低16位)
+			ec::flatmap<uint32_t, PSOCKET, keq_psocket> _map; //已连接表
 
 			void loginfo(int viewcon)
 			{